@@ -111,12 +111,11 @@ int main (int argc, char * const * argv)
 		rai::inactive_node node (data_path);
 		rai::transaction transaction (node.node->store.environment, nullptr, false);
 		rai::uint128_t total;
-		for (auto i (node.node->store.representation_begin (transaction)), n (node.node->store.representation_end ()); i != n; ++i)
+		auto weights (node.node->store.representation_cache.list ());
+		for (auto i (weights.begin ()), n (weights.end ()); i != n; ++i)
 		{
-			rai::account account (i->first.uint256 ());
-			auto amount (node.node->store.representation_get (transaction, account));
-			total += amount;
-			std::cout << boost::str (boost::format ("%1% %2% %3%\n") % account.to_account () % amount.convert_to<std::string> () % total.convert_to<std::string> ());
+			total += i->second;
+			std::cout << boost::str (boost::format ("%1% %2% %3%\n") % i->first.to_account () % i->second.convert_to<std::string> () % total.convert_to<std::string> ());
 		}
 		std::map<rai::account, rai::uint128_t> calculated;
 		for (auto i (node.node->store.latest_begin (transaction)), n (node.node->store.latest_end ()); i != n; ++i)
@@ -160,9 +159,28 @@ int main (int argc, char * const * argv)
 	}
 	else if (vm.count ("debug_profile_generate"))
 	{
+		rai::work_root root;
+		rai::uint256_union root_hash (1);
+		rai::work_root_init (root, root_hash.bytes.data ());
+		for (auto & kernel : rai::work_kernels ())
+		{
+			std::array<uint64_t, 8> nonces;
+			std::array<uint64_t, 8> values;
+			nonces.fill (0);
+			uint64_t count (0);
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			while (count < 1 << 22)
+			{
+				nonces[0] = count;
+				kernel.values (root, nonces.data (), values.data ());
+				count += kernel.lanes;
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Kernel %1% (%2% lanes): %3% hashes/s\n") % kernel.name % kernel.lanes % (count * 1000000 / std::max<int64_t> (1, std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ())));
+		}
 		rai::work_pool work (std::numeric_limits<unsigned>::max (), nullptr);
 		rai::change_block block (0, 0, rai::keypair ().prv, 0, 0);
-		std::cerr << "Starting generation profiling\n";
+		std::cerr << boost::str (boost::format ("Starting generation profiling with kernel %1%\n") % work.kernel.name);
 		for (uint64_t i (0); true; ++i)
 		{
 			block.hashables.previous.qwords[0] += 1;
@@ -2,6 +2,8 @@
 #include <banano/blockstore.hpp>
 #include <banano/versioning.hpp>
 
+size_t constexpr rai::block_store::unchecked_cache_max;
+
 namespace
 {
 /**
@@ -18,13 +20,7 @@ public:
 	virtual ~set_predecessor () = default;
 	void fill_value (rai::block const & block_a)
 	{
-		auto hash (block_a.hash ());
-		rai::block_type type;
-		auto value (store.block_get_raw (transaction, block_a.previous (), type));
-		assert (value.mv_size != 0);
-		std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
-		std::copy (hash.bytes.begin (), hash.bytes.end (), data.end () - hash.bytes.size ());
-		store.block_put_raw (transaction, store.block_database (type), block_a.previous (), rai::mdb_val (data.size (), data.data ()));
+		store.block_successor_set (transaction, block_a.previous (), block_a.hash ());
 	}
 	void send_block (rai::send_block const & block_a) override
 	{
@@ -52,6 +48,48 @@ public:
 	MDB_txn * transaction;
 	rai::block_store & store;
 };
+/**
+ * Carry an account's balance forward from its previous block, only receives look outside the chain
+ */
+class balance_forward : public rai::block_visitor
+{
+public:
+	balance_forward (MDB_txn * transaction_a, rai::block_store & store_a) :
+	transaction (transaction_a),
+	store (store_a),
+	balance (0)
+	{
+	}
+	virtual ~balance_forward () = default;
+	void add_amount (rai::block const & block_a)
+	{
+		rai::amount_visitor amount (transaction, store);
+		amount.compute (block_a.hash ());
+		balance += amount.result;
+	}
+	void send_block (rai::send_block const & block_a) override
+	{
+		balance = block_a.hashables.balance.number ();
+	}
+	void receive_block (rai::receive_block const & block_a) override
+	{
+		add_amount (block_a);
+	}
+	void open_block (rai::open_block const & block_a) override
+	{
+		add_amount (block_a);
+	}
+	void change_block (rai::change_block const & block_a) override
+	{
+	}
+	void state_block (rai::state_block const & block_a) override
+	{
+		balance = block_a.hashables.balance.number ();
+	}
+	MDB_txn * transaction;
+	rai::block_store & store;
+	rai::uint128_t balance;
+};
 }
 
 rai::store_entry::store_entry () :
@@ -240,14 +278,13 @@ rai::store_iterator rai::block_store::vote_end ()
 }
 
 rai::block_store::block_store (bool & error_a, boost::filesystem::path const & path_a, int lmdb_max_dbs) :
+unchecked_cache_size (0),
 environment (error_a, path_a, lmdb_max_dbs),
 frontiers (0),
 accounts (0),
-send_blocks (0),
-receive_blocks (0),
-open_blocks (0),
-change_blocks (0),
+blocks (0),
 pending (0),
+delegators (0),
 blocks_info (0),
 representation (0),
 unchecked (0),
@@ -259,12 +296,9 @@ checksum (0)
 		rai::transaction transaction (environment, nullptr, true);
 		error_a |= mdb_dbi_open (transaction, "frontiers", MDB_CREATE, &frontiers) != 0;
 		error_a |= mdb_dbi_open (transaction, "accounts", MDB_CREATE, &accounts) != 0;
-		error_a |= mdb_dbi_open (transaction, "send", MDB_CREATE, &send_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "receive", MDB_CREATE, &receive_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "open", MDB_CREATE, &open_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "change", MDB_CREATE, &change_blocks) != 0;
-		error_a |= mdb_dbi_open (transaction, "state", MDB_CREATE, &state_blocks) != 0;
+		error_a |= mdb_dbi_open (transaction, "blocks", MDB_CREATE, &blocks) != 0;
 		error_a |= mdb_dbi_open (transaction, "pending", MDB_CREATE, &pending) != 0;
+		error_a |= mdb_dbi_open (transaction, "delegators", MDB_CREATE, &delegators) != 0;
 		error_a |= mdb_dbi_open (transaction, "blocks_info", MDB_CREATE, &blocks_info) != 0;
 		error_a |= mdb_dbi_open (transaction, "representation", MDB_CREATE, &representation) != 0;
 		error_a |= mdb_dbi_open (transaction, "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked) != 0;
@@ -274,6 +308,8 @@ checksum (0)
 		error_a |= mdb_dbi_open (transaction, "meta", MDB_CREATE, &meta) != 0;
 		if (!error_a)
 		{
+			block_count_load (transaction);
+			representation_load (transaction);
 			do_upgrades (transaction);
 			checksum_put (transaction, 0, 0, 0);
 		}
@@ -309,7 +345,13 @@ int rai::block_store::version_get (MDB_txn * transaction_a)
 
 void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 {
-	switch (version_get (transaction_a))
+	auto version (version_get (transaction_a));
+	if (version < 11)
+	{
+		// Earlier upgrades read and write blocks through the current accessors so the blocks table must be populated first
+		upgrade_block_tables (transaction_a);
+	}
+	switch (version)
 	{
 		case 1:
 			upgrade_v1_to_v2 (transaction_a);
@@ -330,6 +372,10 @@ void rai::block_store::do_upgrades (MDB_txn * transaction_a)
 		case 9:
 			upgrade_v9_to_v10 (transaction_a);
 		case 10:
+			upgrade_v10_to_v11 (transaction_a);
+		case 11:
+			upgrade_v11_to_v12 (transaction_a);
+		case 12:
 			break;
 		default:
 			assert (false);
@@ -374,6 +420,7 @@ void rai::block_store::upgrade_v2_to_v3 (MDB_txn * transaction_a)
 {
 	version_put (transaction_a, 3);
 	mdb_drop (transaction_a, representation, 0);
+	representation_cache.clear ();
 	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
 	{
 		rai::account account_l (i->first.uint256 ());
@@ -524,6 +571,89 @@ void rai::block_store::upgrade_v9_to_v10 (MDB_txn * transaction_a)
 	//std::cerr << boost::str (boost::format ("Database upgrade is completed\n"));
 }
 
+// Moves blocks out of the per-type tables in to the blocks table. Sideband account, height and balance are filled in by upgrade_v10_to_v11
+void rai::block_store::upgrade_block_tables (MDB_txn * transaction_a)
+{
+	std::array<std::pair<char const *, rai::block_type>, 5> tables{ { { "send", rai::block_type::send }, { "receive", rai::block_type::receive }, { "open", rai::block_type::open }, { "change", rai::block_type::change }, { "state", rai::block_type::state } } };
+	for (auto & table : tables)
+	{
+		MDB_dbi legacy;
+		auto status (mdb_dbi_open (transaction_a, table.first, 0, &legacy));
+		if (status == 0)
+		{
+			for (rai::store_iterator i (transaction_a, legacy), n (nullptr); i != n; ++i)
+			{
+				// Legacy values are the serialized block followed by the successor
+				auto data (reinterpret_cast<uint8_t const *> (i->second.data ()));
+				auto size (i->second.size ());
+				assert (size >= sizeof (rai::block_hash));
+				rai::block_sideband sideband;
+				std::copy (data + size - sizeof (rai::block_hash), data + size, sideband.successor.bytes.begin ());
+				std::vector<uint8_t> vector;
+				{
+					rai::vectorstream stream (vector);
+					rai::write (stream, table.second);
+					stream.sputn (data, size - sizeof (rai::block_hash));
+					sideband.serialize (stream);
+				}
+				block_put_raw (transaction_a, i->first.uint256 (), rai::mdb_val (vector.size (), vector.data ()));
+				block_count_add (transaction_a, table.second, 1);
+			}
+			auto status2 (mdb_drop (transaction_a, legacy, 1));
+			assert (status2 == 0);
+		}
+		else
+		{
+			assert (status == MDB_NOTFOUND);
+		}
+	}
+}
+
+void rai::block_store::upgrade_v10_to_v11 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 11);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account account (i->first.uint256 ());
+		rai::account_info info (i->second);
+		uint64_t height (1);
+		balance_forward balance (transaction_a, *this);
+		auto hash (info.open_block);
+		while (!hash.is_zero ())
+		{
+			rai::block_sideband sideband;
+			auto block (block_get (transaction_a, hash, &sideband));
+			assert (block != nullptr);
+			block->visit (balance);
+			assert (hash != info.head || balance.balance == info.balance.number ());
+			sideband.account = account;
+			sideband.height = height;
+			sideband.balance = balance.balance;
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				rai::serialize_block (stream, *block);
+				sideband.serialize (stream);
+			}
+			block_put_raw (transaction_a, hash, rai::mdb_val (vector.size (), vector.data ()));
+			hash = sideband.successor;
+			++height;
+		}
+	}
+}
+
+void rai::block_store::upgrade_v11_to_v12 (MDB_txn * transaction_a)
+{
+	version_put (transaction_a, 12);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		rai::account_info info (i->second);
+		auto block (block_get (transaction_a, info.rep_block));
+		assert (block != nullptr);
+		delegator_put (transaction_a, block->representative (), i->first.uint256 (), info.balance);
+	}
+}
+
 void rai::block_store::clear (MDB_dbi db_a)
 {
 	rai::transaction transaction (environment, nullptr, true);
@@ -547,49 +677,34 @@ void rai::block_store::representation_add (MDB_txn * transaction_a, rai::block_h
 	representation_put (transaction_a, source_rep, source_previous + amount_a);
 }
 
-MDB_dbi rai::block_store::block_database (rai::block_type type_a)
+void rai::block_store::block_put_raw (MDB_txn * transaction_a, rai::block_hash const & hash_a, MDB_val value_a)
 {
-	MDB_dbi result;
-	switch (type_a)
-	{
-		case rai::block_type::send:
-			result = send_blocks;
-			break;
-		case rai::block_type::receive:
-			result = receive_blocks;
-			break;
-		case rai::block_type::open:
-			result = open_blocks;
-			break;
-		case rai::block_type::change:
-			result = change_blocks;
-			break;
-		case rai::block_type::state:
-			result = state_blocks;
-			break;
-		default:
-			assert (false);
-			break;
-	}
-	return result;
-}
-
-void rai::block_store::block_put_raw (MDB_txn * transaction_a, MDB_dbi database_a, rai::block_hash const & hash_a, MDB_val value_a)
-{
-	auto status2 (mdb_put (transaction_a, database_a, rai::mdb_val (hash_a), &value_a, 0));
+	auto status2 (mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), &value_a, 0));
 	assert (status2 == 0);
 }
 
-void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_hash const & successor_a)
+void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_sideband const & sideband_a)
 {
-	assert (successor_a.is_zero () || block_exists (transaction_a, successor_a));
+	assert (sideband_a.successor.is_zero () || block_exists (transaction_a, sideband_a.successor));
 	std::vector<uint8_t> vector;
 	{
 		rai::vectorstream stream (vector);
-		block_a.serialize (stream);
-		rai::write (stream, successor_a.bytes);
+		rai::serialize_block (stream, block_a);
+		sideband_a.serialize (stream);
+	}
+	rai::mdb_val value (vector.size (), vector.data ());
+	auto status (mdb_put (transaction_a, blocks, rai::mdb_val (hash_a), value, MDB_NOOVERWRITE));
+	if (status == MDB_KEYEXIST)
+	{
+		// Replacing a block, value now refers to the existing entry
+		block_count_add (transaction_a, static_cast<rai::block_type> (*reinterpret_cast<uint8_t const *> (value.data ())), -1);
+		block_put_raw (transaction_a, hash_a, rai::mdb_val (vector.size (), vector.data ()));
 	}
-	block_put_raw (transaction_a, block_database (block_a.type ()), hash_a, { vector.size (), vector.data () });
+	else
+	{
+		assert (status == 0);
+	}
+	block_count_add (transaction_a, block_a.type (), 1);
 	set_predecessor predecessor (transaction_a, *this);
 	block_a.visit (predecessor);
 	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
@@ -598,106 +713,35 @@ void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const
 MDB_val rai::block_store::block_get_raw (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_type & type_a)
 {
 	rai::mdb_val result;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), result));
+	auto status (mdb_get (transaction_a, blocks, rai::mdb_val (hash_a), result));
 	assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
-	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), result));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		if (status != 0)
-		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), result));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			if (status != 0)
-			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), result));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				if (status != 0)
-				{
-					auto status (mdb_get (transaction_a, state_blocks, rai::mdb_val (hash_a), result));
-					assert (status == 0 || status == MDB_NOTFOUND);
-					if (status != 0)
-					{
-						// Block not found
-					}
-					else
-					{
-						type_a = rai::block_type::state;
-					}
-				}
-				else
-				{
-					type_a = rai::block_type::change;
-				}
-			}
-			else
-			{
-				type_a = rai::block_type::open;
-			}
-		}
-		else
-		{
-			type_a = rai::block_type::receive;
-		}
-	}
-	else
+	if (status == 0)
 	{
-		type_a = rai::block_type::send;
+		assert (result.size () > rai::block_sideband::size);
+		type_a = static_cast<rai::block_type> (*reinterpret_cast<uint8_t const *> (result.data ()));
 	}
 	return result;
 }
 
-std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transaction_a, MDB_dbi database)
+std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transaction_a)
 {
 	rai::block_hash hash;
 	rai::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
-	rai::store_iterator existing (transaction_a, database, rai::mdb_val (hash));
+	rai::store_iterator existing (transaction_a, blocks, rai::mdb_val (hash));
 	if (existing == rai::store_iterator (nullptr))
 	{
-		existing = rai::store_iterator (transaction_a, database);
+		existing = rai::store_iterator (transaction_a, blocks);
 	}
 	assert (existing != rai::store_iterator (nullptr));
 	return block_get (transaction_a, rai::block_hash (existing->first.uint256 ()));
 }
 
-std::unique_ptr<rai::block> rai::block_store::block_random (MDB_txn * transaction_a)
+void rai::block_store::block_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block const & block_a, rai::block_hash const & successor_a)
 {
-	auto count (block_count (transaction_a));
-	auto region (rai::random_pool.GenerateWord32 (0, count.sum () - 1));
-	std::unique_ptr<rai::block> result;
-	if (region < count.send)
-	{
-		result = block_random (transaction_a, send_blocks);
-	}
-	else
-	{
-		region -= count.send;
-		if (region < count.receive)
-		{
-			result = block_random (transaction_a, receive_blocks);
-		}
-		else
-		{
-			region -= count.receive;
-			if (region < count.open)
-			{
-				result = block_random (transaction_a, open_blocks);
-			}
-			else
-			{
-				region -= count.open;
-				if (region < count.change)
-				{
-					result = block_random (transaction_a, change_blocks);
-				}
-				else
-				{
-					result = block_random (transaction_a, state_blocks);
-				}
-			}
-		}
-	}
-	return result;
+	rai::block_sideband sideband;
+	block_get (transaction_a, hash_a, &sideband);
+	sideband.successor = successor_a;
+	block_put (transaction_a, hash_a, block_a, sideband);
 }
 
 rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai::block_hash const & hash_a)
@@ -707,8 +751,8 @@ rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai:
 	rai::block_hash result;
 	if (value.mv_size != 0)
 	{
-		assert (value.mv_size >= result.bytes.size ());
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + value.mv_size - result.bytes.size (), result.bytes.size ());
+		// Successor is the first field of the sideband at the end of the value
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data) + value.mv_size - rai::block_sideband::size, result.bytes.size ());
 		auto error (rai::read (stream, result.bytes));
 		assert (!error);
 	}
@@ -719,13 +763,22 @@ rai::block_hash rai::block_store::block_successor (MDB_txn * transaction_a, rai:
 	return result;
 }
 
+void rai::block_store::block_successor_set (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_hash const & successor_a)
+{
+	rai::block_type type;
+	auto value (block_get_raw (transaction_a, hash_a, type));
+	assert (value.mv_size != 0);
+	std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
+	std::copy (successor_a.bytes.begin (), successor_a.bytes.end (), data.end () - rai::block_sideband::size);
+	block_put_raw (transaction_a, hash_a, rai::mdb_val (data.size (), data.data ()));
+}
+
 void rai::block_store::block_successor_clear (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto block (block_get (transaction_a, hash_a));
-	block_put (transaction_a, hash_a, *block);
+	block_successor_set (transaction_a, hash_a, rai::block_hash (0));
 }
 
-std::unique_ptr<rai::block> rai::block_store::block_get (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+std::unique_ptr<rai::block> rai::block_store::block_get (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_sideband * sideband_a)
 {
 	rai::block_type type;
 	auto value (block_get_raw (transaction_a, hash_a, type));
@@ -733,95 +786,132 @@ std::unique_ptr<rai::block> rai::block_store::block_get (MDB_txn * transaction_a
 	if (value.mv_size != 0)
 	{
 		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
-		result = rai::deserialize_block (stream, type);
+		result = rai::deserialize_block (stream);
 		assert (result != nullptr);
+		if (sideband_a != nullptr)
+		{
+			auto error (sideband_a->deserialize (stream));
+			assert (!error);
+		}
 	}
 	return result;
 }
 
 void rai::block_store::block_del (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto status (mdb_del (transaction_a, state_blocks, rai::mdb_val (hash_a), nullptr));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
-	{
-		auto status (mdb_del (transaction_a, send_blocks, rai::mdb_val (hash_a), nullptr));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		if (status != 0)
-		{
-			auto status (mdb_del (transaction_a, receive_blocks, rai::mdb_val (hash_a), nullptr));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			if (status != 0)
-			{
-				auto status (mdb_del (transaction_a, open_blocks, rai::mdb_val (hash_a), nullptr));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				if (status != 0)
-				{
-					auto status (mdb_del (transaction_a, change_blocks, rai::mdb_val (hash_a), nullptr));
-					assert (status == 0);
-				}
-			}
-		}
-	}
+	rai::block_type type;
+	auto value (block_get_raw (transaction_a, hash_a, type));
+	assert (value.mv_size != 0);
+	auto status (mdb_del (transaction_a, blocks, rai::mdb_val (hash_a), nullptr));
+	assert (status == 0);
+	block_count_add (transaction_a, type, -1);
 }
 
 bool rai::block_store::block_exists (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
-	auto exists (true);
 	rai::mdb_val junk;
-	auto status (mdb_get (transaction_a, send_blocks, rai::mdb_val (hash_a), junk));
+	auto status (mdb_get (transaction_a, blocks, rai::mdb_val (hash_a), junk));
 	assert (status == 0 || status == MDB_NOTFOUND);
-	exists = status == 0;
-	if (!exists)
+	return status == 0;
+}
+
+rai::block_counts rai::block_store::block_count (MDB_txn * transaction_a)
+{
+	return counts.get ();
+}
+
+// Block counts are maintained as blocks are added and removed and persisted in meta so they survive restarts
+void rai::block_store::block_count_add (MDB_txn * transaction_a, rai::block_type type_a, int64_t amount_a)
+{
+	counts.add (type_a, amount_a);
+	auto current (counts.get ());
+	std::vector<uint8_t> vector;
 	{
-		auto status (mdb_get (transaction_a, receive_blocks, rai::mdb_val (hash_a), junk));
-		assert (status == 0 || status == MDB_NOTFOUND);
-		exists = status == 0;
-		if (!exists)
-		{
-			auto status (mdb_get (transaction_a, open_blocks, rai::mdb_val (hash_a), junk));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			if (!exists)
-			{
-				auto status (mdb_get (transaction_a, change_blocks, rai::mdb_val (hash_a), junk));
-				assert (status == 0 || status == MDB_NOTFOUND);
-				exists = status == 0;
-				if (!exists)
-				{
-					auto status (mdb_get (transaction_a, state_blocks, rai::mdb_val (hash_a), junk));
-					assert (status == 0 || status == MDB_NOTFOUND);
-					exists = status == 0;
-				}
-			}
-		}
+		rai::vectorstream stream (vector);
+		rai::write (stream, static_cast<uint64_t> (current.send));
+		rai::write (stream, static_cast<uint64_t> (current.receive));
+		rai::write (stream, static_cast<uint64_t> (current.open));
+		rai::write (stream, static_cast<uint64_t> (current.change));
+		rai::write (stream, static_cast<uint64_t> (current.state));
+	}
+	rai::uint256_union block_count_key (2);
+	auto status (mdb_put (transaction_a, meta, rai::mdb_val (block_count_key), rai::mdb_val (vector.size (), vector.data ()), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::block_count_load (MDB_txn * transaction_a)
+{
+	rai::block_counts result;
+	rai::uint256_union block_count_key (2);
+	rai::mdb_val data;
+	auto status (mdb_get (transaction_a, meta, rai::mdb_val (block_count_key), data));
+	assert (status == 0 || status == MDB_NOTFOUND);
+	if (status == 0)
+	{
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (data.data ()), data.size ());
+		uint64_t send, receive, open, change, state;
+		auto error (rai::read (stream, send) || rai::read (stream, receive) || rai::read (stream, open) || rai::read (stream, change) || rai::read (stream, state));
+		assert (!error);
+		result.send = send;
+		result.receive = receive;
+		result.open = open;
+		result.change = change;
+		result.state = state;
 	}
-	return exists;
+	counts.set (result);
 }
 
-rai::block_counts rai::block_store::block_count (MDB_txn * transaction_a)
+rai::block_counter::block_counter () :
+send (0),
+receive (0),
+open (0),
+change (0),
+state (0)
+{
+}
+
+void rai::block_counter::add (rai::block_type type_a, int64_t amount_a)
+{
+	switch (type_a)
+	{
+		case rai::block_type::send:
+			send += amount_a;
+			break;
+		case rai::block_type::receive:
+			receive += amount_a;
+			break;
+		case rai::block_type::open:
+			open += amount_a;
+			break;
+		case rai::block_type::change:
+			change += amount_a;
+			break;
+		case rai::block_type::state:
+			state += amount_a;
+			break;
+		default:
+			assert (false);
+			break;
+	}
+}
+
+void rai::block_counter::set (rai::block_counts const & counts_a)
+{
+	send = counts_a.send;
+	receive = counts_a.receive;
+	open = counts_a.open;
+	change = counts_a.change;
+	state = counts_a.state;
+}
+
+rai::block_counts rai::block_counter::get () const
 {
 	rai::block_counts result;
-	MDB_stat send_stats;
-	auto status1 (mdb_stat (transaction_a, send_blocks, &send_stats));
-	assert (status1 == 0);
-	MDB_stat receive_stats;
-	auto status2 (mdb_stat (transaction_a, receive_blocks, &receive_stats));
-	assert (status2 == 0);
-	MDB_stat open_stats;
-	auto status3 (mdb_stat (transaction_a, open_blocks, &open_stats));
-	assert (status3 == 0);
-	MDB_stat change_stats;
-	auto status4 (mdb_stat (transaction_a, change_blocks, &change_stats));
-	assert (status4 == 0);
-	MDB_stat state_stats;
-	auto status5 (mdb_stat (transaction_a, state_blocks, &state_stats));
-	assert (status5 == 0);
-	result.send = send_stats.ms_entries;
-	result.receive = receive_stats.ms_entries;
-	result.open = open_stats.ms_entries;
-	result.change = change_stats.ms_entries;
-	result.state = state_stats.ms_entries;
+	result.send = send.load ();
+	result.receive = receive.load ();
+	result.open = open.load ();
+	result.change = change.load ();
+	result.state = state.load ();
 	return result;
 }
 
@@ -955,6 +1045,60 @@ rai::store_iterator rai::block_store::pending_end ()
 	return result;
 }
 
+namespace
+{
+rai::uint512_union delegator_key (rai::account const & representative_a, rai::account const & account_a)
+{
+	rai::uint512_union result;
+	result.uint256s[0] = representative_a;
+	result.uint256s[1] = account_a;
+	return result;
+}
+}
+
+void rai::block_store::delegator_put (MDB_txn * transaction_a, rai::account const & representative_a, rai::account const & account_a, rai::amount const & balance_a)
+{
+	auto key (delegator_key (representative_a, account_a));
+	auto status (mdb_put (transaction_a, delegators, rai::mdb_val (sizeof (key), &key), rai::mdb_val (balance_a), 0));
+	assert (status == 0);
+}
+
+void rai::block_store::delegator_del (MDB_txn * transaction_a, rai::account const & representative_a, rai::account const & account_a)
+{
+	auto key (delegator_key (representative_a, account_a));
+	auto status (mdb_del (transaction_a, delegators, rai::mdb_val (sizeof (key), &key), nullptr));
+	assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+rai::store_iterator rai::block_store::delegators_begin (MDB_txn * transaction_a, rai::account const & representative_a, rai::account const & start_a)
+{
+	auto key (delegator_key (representative_a, start_a));
+	rai::store_iterator result (transaction_a, delegators, rai::mdb_val (sizeof (key), &key));
+	return result;
+}
+
+rai::store_iterator rai::block_store::delegators_end ()
+{
+	rai::store_iterator result (nullptr);
+	return result;
+}
+
+rai::account rai::block_store::delegator_representative (rai::mdb_val const & key_a)
+{
+	assert (key_a.size () == sizeof (rai::uint512_union));
+	rai::account result;
+	std::copy (reinterpret_cast<uint8_t const *> (key_a.data ()), reinterpret_cast<uint8_t const *> (key_a.data ()) + sizeof (result), result.bytes.begin ());
+	return result;
+}
+
+rai::account rai::block_store::delegator_account (rai::mdb_val const & key_a)
+{
+	assert (key_a.size () == sizeof (rai::uint512_union));
+	rai::account result;
+	std::copy (reinterpret_cast<uint8_t const *> (key_a.data ()) + sizeof (result), reinterpret_cast<uint8_t const *> (key_a.data ()) + 2 * sizeof (result), result.bytes.begin ());
+	return result;
+}
+
 void rai::block_store::block_info_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, rai::block_info const & block_info_a)
 {
 	auto status (mdb_put (transaction_a, blocks_info, rai::mdb_val (hash_a), block_info_a.val (), 0));
@@ -998,56 +1142,105 @@ bool rai::block_store::block_info_get (MDB_txn * transaction_a, rai::block_hash
 
 rai::uint128_t rai::block_store::representation_get (MDB_txn * transaction_a, rai::account const & account_a)
 {
-	rai::mdb_val value;
-	auto status (mdb_get (transaction_a, representation, rai::mdb_val (account_a), value));
-	assert (status == 0 || status == MDB_NOTFOUND);
-	rai::uint128_t result;
-	if (status == 0)
+	return representation_cache.get (account_a);
+}
+
+void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & representation_a)
+{
+	rai::uint128_union rep (representation_a);
+	auto status (mdb_put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
+	assert (status == 0);
+	representation_cache.put (account_a, representation_a);
+}
+
+void rai::block_store::representation_load (MDB_txn * transaction_a)
+{
+	representation_cache.clear ();
+	for (auto i (representation_begin (transaction_a)), n (representation_end ()); i != n; ++i)
 	{
 		rai::uint128_union rep;
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
 		auto error (rai::read (stream, rep));
 		assert (!error);
-		result = rep.number ();
+		representation_cache.put (i->first.uint256 (), rep.number ());
+	}
+}
+
+void rai::rep_weights::put (rai::account const & account_a, rai::uint128_t const & weight_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	if (!weight_a.is_zero ())
+	{
+		weights[account_a] = weight_a;
 	}
 	else
 	{
-		result = 0;
+		weights.erase (account_a);
+	}
+}
+
+rai::uint128_t rai::rep_weights::get (rai::account const & account_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	rai::uint128_t result (0);
+	auto existing (weights.find (account_a));
+	if (existing != weights.end ())
+	{
+		result = existing->second;
 	}
 	return result;
 }
 
-void rai::block_store::representation_put (MDB_txn * transaction_a, rai::account const & account_a, rai::uint128_t const & representation_a)
+std::vector<std::pair<rai::account, rai::uint128_t>> rai::rep_weights::list ()
 {
-	rai::uint128_union rep (representation_a);
-	auto status (mdb_put (transaction_a, representation, rai::mdb_val (account_a), rai::mdb_val (rep), 0));
-	assert (status == 0);
+	std::vector<std::pair<rai::account, rai::uint128_t>> result;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		result.assign (weights.begin (), weights.end ());
+	}
+	std::sort (result.begin (), result.end (), [](std::pair<rai::account, rai::uint128_t> const & lhs, std::pair<rai::account, rai::uint128_t> const & rhs) { return lhs.first < rhs.first; });
+	return result;
+}
+
+void rai::rep_weights::clear ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	weights.clear ();
 }
 
 void rai::block_store::unchecked_clear (MDB_txn * transaction_a)
 {
 	auto status (mdb_drop (transaction_a, unchecked, 0));
 	assert (status == 0);
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	unchecked_cache.clear ();
+	unchecked_cache_size = 0;
 }
 
 void rai::block_store::unchecked_put (MDB_txn * transaction_a, rai::block_hash const & hash_a, std::shared_ptr<rai::block> const & block_a)
 {
-	// Checking if same unchecked block is already in database
-	bool exists (false);
 	auto block_hash (block_a->hash ());
-	auto cached (unchecked_get (transaction_a, hash_a));
-	for (auto i (cached.begin ()), n (cached.end ()); i != n && !exists; ++i)
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	// Only the blocks in memory are checked for a duplicate, the unchecked table is sorted by value and already ignores an identical put
+	auto existing (unchecked_cache.find (hash_a));
+	auto exists (existing != unchecked_cache.end () && std::any_of (existing->second.begin (), existing->second.end (), [&block_hash](std::shared_ptr<rai::block> const & block_l) { return block_l->hash () == block_hash; }));
+	if (!exists)
 	{
-		if ((*i)->hash () == block_hash)
+		if (unchecked_cache_size < unchecked_cache_max)
 		{
-			exists = true;
+			unchecked_cache[hash_a].push_back (block_a);
+			++unchecked_cache_size;
+		}
+		else
+		{
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				rai::serialize_block (stream, *block_a);
+			}
+			auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (hash_a), rai::mdb_val (vector.size (), vector.data ()), 0));
+			assert (status == 0);
 		}
-	}
-	// Inserting block if it wasn't found in database
-	if (!exists)
-	{
-		std::lock_guard<std::mutex> lock (cache_mutex);
-		unchecked_cache.insert (std::make_pair (hash_a, block_a));
 	}
 }
 
@@ -1070,15 +1263,19 @@ std::vector<std::shared_ptr<rai::block>> rai::block_store::unchecked_get (MDB_tx
 	std::vector<std::shared_ptr<rai::block>> result;
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a; ++i)
+		auto existing (unchecked_cache.find (hash_a));
+		if (existing != unchecked_cache.end ())
 		{
-			result.push_back (i->second);
+			result = existing->second;
 		}
 	}
-	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && rai::block_hash (i->first.uint256 ()) == hash_a; i.next_dup ())
+	if (unchecked_stored (transaction_a) > 0)
 	{
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-		result.push_back (rai::deserialize_block (stream));
+		for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && rai::block_hash (i->first.uint256 ()) == hash_a; i.next_dup ())
+		{
+			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+			result.push_back (rai::deserialize_block (stream));
+		}
 	}
 	return result;
 }
@@ -1087,15 +1284,25 @@ void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::block_hash c
 {
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
-		for (auto i (unchecked_cache.find (hash_a)), n (unchecked_cache.end ()); i != n && i->first == hash_a;)
+		auto existing (unchecked_cache.find (hash_a));
+		if (existing != unchecked_cache.end ())
 		{
-			if (*i->second == block_a)
+			auto & blocks_l (existing->second);
+			for (auto i (blocks_l.begin ()); i != blocks_l.end ();)
 			{
-				i = unchecked_cache.erase (i);
+				if (**i == block_a)
+				{
+					i = blocks_l.erase (i);
+					--unchecked_cache_size;
+				}
+				else
+				{
+					++i;
+				}
 			}
-			else
+			if (blocks_l.empty ())
 			{
-				++i;
+				unchecked_cache.erase (existing);
 			}
 		}
 	}
@@ -1108,7 +1315,85 @@ void rai::block_store::unchecked_del (MDB_txn * transaction_a, rai::block_hash c
 	assert (status == 0 || status == MDB_NOTFOUND);
 }
 
+std::vector<std::pair<rai::block_hash, std::shared_ptr<rai::block>>> rai::block_store::unchecked_release (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	std::vector<std::pair<rai::block_hash, std::shared_ptr<rai::block>>> result;
+	{
+		std::lock_guard<std::mutex> lock (cache_mutex);
+		auto existing (unchecked_cache.find (hash_a));
+		if (existing != unchecked_cache.end ())
+		{
+			for (auto & i : existing->second)
+			{
+				result.push_back (std::make_pair (hash_a, std::move (i)));
+			}
+			unchecked_cache_size -= existing->second.size ();
+			unchecked_cache.erase (existing);
+		}
+	}
+	if (unchecked_stored (transaction_a) > 0)
+	{
+		auto found (false);
+		for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && rai::block_hash (i->first.uint256 ()) == hash_a; i.next_dup ())
+		{
+			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+			result.push_back (std::make_pair (hash_a, rai::deserialize_block (stream)));
+			found = true;
+		}
+		if (found)
+		{
+			auto status (mdb_del (transaction_a, unchecked, rai::mdb_val (hash_a), nullptr));
+			assert (status == 0);
+		}
+	}
+	return result;
+}
+
+void rai::block_store::unchecked_cached (std::function<bool (rai::block_hash const &, std::shared_ptr<rai::block> const &)> const & action_a)
+{
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	auto done (false);
+	for (auto i (unchecked_cache.begin ()), n (unchecked_cache.end ()); i != n && !done; ++i)
+	{
+		for (auto j (i->second.begin ()), m (i->second.end ()); j != m && !done; ++j)
+		{
+			done = action_a (i->first, *j);
+		}
+	}
+}
+
+void rai::block_store::unchecked_flush (MDB_txn * transaction_a)
+{
+	std::unordered_map<rai::block_hash, std::vector<std::shared_ptr<rai::block>>> unchecked_cache_l;
+	{
+		std::lock_guard<std::mutex> lock (cache_mutex);
+		unchecked_cache_l.swap (unchecked_cache);
+		unchecked_cache_size = 0;
+	}
+	for (auto & i : unchecked_cache_l)
+	{
+		for (auto & j : i.second)
+		{
+			std::vector<uint8_t> vector;
+			{
+				rai::vectorstream stream (vector);
+				rai::serialize_block (stream, *j);
+			}
+			auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (i.first), rai::mdb_val (vector.size (), vector.data ()), 0));
+			assert (status == 0);
+		}
+	}
+}
+
 size_t rai::block_store::unchecked_count (MDB_txn * transaction_a)
+{
+	size_t result (unchecked_stored (transaction_a));
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	result += unchecked_cache_size;
+	return result;
+}
+
+size_t rai::block_store::unchecked_stored (MDB_txn * transaction_a)
 {
 	MDB_stat unchecked_stats;
 	auto status (mdb_stat (transaction_a, unchecked, &unchecked_stats));
@@ -1188,24 +1473,12 @@ void rai::block_store::checksum_del (MDB_txn * transaction_a, uint64_t prefix, u
 	assert (status == 0);
 }
 
-void rai::block_store::flush (MDB_txn * transaction_a)
+void rai::block_store::vote_flush (MDB_txn * transaction_a)
 {
 	std::unordered_map<rai::account, std::shared_ptr<rai::vote>> sequence_cache_l;
-	std::unordered_multimap<rai::block_hash, std::shared_ptr<rai::block>> unchecked_cache_l;
 	{
 		std::lock_guard<std::mutex> lock (cache_mutex);
 		sequence_cache_l.swap (vote_cache);
-		unchecked_cache_l.swap (unchecked_cache);
-	}
-	for (auto & i : unchecked_cache_l)
-	{
-		std::vector<uint8_t> vector;
-		{
-			rai::vectorstream stream (vector);
-			rai::serialize_block (stream, *i.second);
-		}
-		auto status (mdb_put (transaction_a, unchecked, rai::mdb_val (i.first), rai::mdb_val (vector.size (), vector.data ()), 0));
-		assert (status == 0);
 	}
 	for (auto i (sequence_cache_l.begin ()), n (sequence_cache_l.end ()); i != n; ++i)
 	{
@@ -1218,6 +1491,13 @@ void rai::block_store::flush (MDB_txn * transaction_a)
 		assert (status1 == 0);
 	}
 }
+
+void rai::block_store::flush (MDB_txn * transaction_a)
+{
+	unchecked_flush (transaction_a);
+	vote_flush (transaction_a);
+}
+
 std::shared_ptr<rai::vote> rai::block_store::vote_current (MDB_txn * transaction_a, rai::account const & account_a)
 {
 	assert (!cache_mutex.try_lock ());
@@ -1244,6 +1524,13 @@ std::shared_ptr<rai::vote> rai::block_store::vote_generate (MDB_txn * transactio
 	return result;
 }
 
+uint64_t rai::block_store::vote_sequence (MDB_txn * transaction_a, rai::account const & account_a)
+{
+	std::lock_guard<std::mutex> lock (cache_mutex);
+	auto current (vote_current (transaction_a, account_a));
+	return current != nullptr ? current->sequence : 0;
+}
+
 std::shared_ptr<rai::vote> rai::block_store::vote_max (MDB_txn * transaction_a, std::shared_ptr<rai::vote> vote_a)
 {
 	std::lock_guard<std::mutex> lock (cache_mutex);
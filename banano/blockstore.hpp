@@ -2,6 +2,8 @@
 
 #include <banano/common.hpp>
 
+#include <functional>
+
 namespace rai
 {
 /**
@@ -40,6 +42,38 @@ public:
 	rai::store_entry current;
 };
 
+/**
+ * Number of blocks of each type, kept in memory so counting never touches the database
+ */
+class block_counter
+{
+public:
+	block_counter ();
+	void add (rai::block_type, int64_t);
+	void set (rai::block_counts const &);
+	rai::block_counts get () const;
+	std::atomic<uint64_t> send;
+	std::atomic<uint64_t> receive;
+	std::atomic<uint64_t> open;
+	std::atomic<uint64_t> change;
+	std::atomic<uint64_t> state;
+};
+
+/**
+ * Copy of the representation table kept in memory so weight lookups don't read the database
+ */
+class rep_weights
+{
+public:
+	void put (rai::account const &, rai::uint128_t const &);
+	rai::uint128_t get (rai::account const &);
+	// Every representative with weight, in account order like the representation table
+	std::vector<std::pair<rai::account, rai::uint128_t>> list ();
+	void clear ();
+	std::mutex mutex;
+	std::unordered_map<rai::account, rai::uint128_t> weights;
+};
+
 /**
  * Manages block storage and iteration
  */
@@ -48,18 +82,22 @@ class block_store
 public:
 	block_store (bool &, boost::filesystem::path const &, int lmdb_max_dbs = 128);
 
-	MDB_dbi block_database (rai::block_type);
-	void block_put_raw (MDB_txn *, MDB_dbi, rai::block_hash const &, MDB_val);
-	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_hash const & = rai::block_hash (0));
+	void block_put_raw (MDB_txn *, rai::block_hash const &, MDB_val);
+	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_sideband const & = rai::block_sideband ());
+	// Replaces the successor and keeps the rest of any existing sideband
+	void block_put (MDB_txn *, rai::block_hash const &, rai::block const &, rai::block_hash const &);
 	MDB_val block_get_raw (MDB_txn *, rai::block_hash const &, rai::block_type &);
 	rai::block_hash block_successor (MDB_txn *, rai::block_hash const &);
+	void block_successor_set (MDB_txn *, rai::block_hash const &, rai::block_hash const &);
 	void block_successor_clear (MDB_txn *, rai::block_hash const &);
-	std::unique_ptr<rai::block> block_get (MDB_txn *, rai::block_hash const &);
+	std::unique_ptr<rai::block> block_get (MDB_txn *, rai::block_hash const &, rai::block_sideband * = nullptr);
 	std::unique_ptr<rai::block> block_random (MDB_txn *);
-	std::unique_ptr<rai::block> block_random (MDB_txn *, MDB_dbi);
 	void block_del (MDB_txn *, rai::block_hash const &);
 	bool block_exists (MDB_txn *, rai::block_hash const &);
 	rai::block_counts block_count (MDB_txn *);
+	void block_count_add (MDB_txn *, rai::block_type, int64_t);
+	void block_count_load (MDB_txn *);
+	rai::block_counter counts;
 
 	void frontier_put (MDB_txn *, rai::block_hash const &, rai::account const &);
 	rai::account frontier_get (MDB_txn *, rai::block_hash const &);
@@ -82,6 +120,14 @@ public:
 	rai::store_iterator pending_begin (MDB_txn *);
 	rai::store_iterator pending_end ();
 
+	void delegator_put (MDB_txn *, rai::account const &, rai::account const &, rai::amount const &);
+	void delegator_del (MDB_txn *, rai::account const &, rai::account const &);
+	// Iterates from the representative's first delegator, callers stop once delegator_representative changes
+	rai::store_iterator delegators_begin (MDB_txn *, rai::account const &, rai::account const & = rai::account (0));
+	rai::store_iterator delegators_end ();
+	static rai::account delegator_representative (rai::mdb_val const &);
+	static rai::account delegator_account (rai::mdb_val const &);
+
 	void block_info_put (MDB_txn *, rai::block_hash const &, rai::block_info const &);
 	void block_info_del (MDB_txn *, rai::block_hash const &);
 	bool block_info_get (MDB_txn *, rai::block_hash const &, rai::block_info &);
@@ -97,16 +143,29 @@ public:
 	void representation_add (MDB_txn *, rai::account const &, rai::uint128_t const &);
 	rai::store_iterator representation_begin (MDB_txn *);
 	rai::store_iterator representation_end ();
+	void representation_load (MDB_txn *);
+	rai::rep_weights representation_cache;
 
 	void unchecked_clear (MDB_txn *);
 	void unchecked_put (MDB_txn *, rai::block_hash const &, std::shared_ptr<rai::block> const &);
 	std::vector<std::shared_ptr<rai::block>> unchecked_get (MDB_txn *, rai::block_hash const &);
 	void unchecked_del (MDB_txn *, rai::block_hash const &, rai::block const &);
+	// Remove and return the blocks waiting directly on hash, their own dependents are released once they're processed
+	std::vector<std::pair<rai::block_hash, std::shared_ptr<rai::block>>> unchecked_release (MDB_txn *, rai::block_hash const &);
+	// Visit the blocks held in memory under the cache lock until the action returns true, these aren't visible through unchecked_begin
+	void unchecked_cached (std::function<bool (rai::block_hash const &, std::shared_ptr<rai::block> const &)> const &);
+	// Write blocks held in memory to the unchecked table
+	void unchecked_flush (MDB_txn *);
 	rai::store_iterator unchecked_begin (MDB_txn *);
 	rai::store_iterator unchecked_begin (MDB_txn *, rai::block_hash const &);
 	rai::store_iterator unchecked_end ();
 	size_t unchecked_count (MDB_txn *);
-	std::unordered_multimap<rai::block_hash, std::shared_ptr<rai::block>> unchecked_cache;
+	// Number of blocks in the unchecked table, excluding those held in memory
+	size_t unchecked_stored (MDB_txn *);
+	// Blocks waiting on a missing dependency, keyed by that dependency. Written to the unchecked table by flush, and once full new entries spill there directly
+	std::unordered_map<rai::block_hash, std::vector<std::shared_ptr<rai::block>>> unchecked_cache;
+	size_t unchecked_cache_size;
+	static size_t constexpr unchecked_cache_max = 256 * 1024;
 
 	void unsynced_put (MDB_txn *, rai::block_hash const &);
 	void unsynced_del (MDB_txn *, rai::block_hash const &);
@@ -127,6 +186,9 @@ public:
 	std::shared_ptr<rai::vote> vote_max (MDB_txn *, std::shared_ptr<rai::vote>);
 	// Return latest vote for an account considering the vote cache
 	std::shared_ptr<rai::vote> vote_current (MDB_txn *, rai::account const &);
+	// Return the highest sequence number known for an account, 0 if it hasn't voted
+	uint64_t vote_sequence (MDB_txn *, rai::account const &);
+	void vote_flush (MDB_txn *);
 	void flush (MDB_txn *);
 	rai::store_iterator vote_begin (MDB_txn *);
 	rai::store_iterator vote_end ();
@@ -145,6 +207,9 @@ public:
 	void upgrade_v7_to_v8 (MDB_txn *);
 	void upgrade_v8_to_v9 (MDB_txn *);
 	void upgrade_v9_to_v10 (MDB_txn *);
+	void upgrade_v10_to_v11 (MDB_txn *);
+	void upgrade_v11_to_v12 (MDB_txn *);
+	void upgrade_block_tables (MDB_txn *);
 
 	void clear (MDB_dbi);
 
@@ -153,18 +218,12 @@ public:
 	MDB_dbi frontiers;
 	// account -> block_hash, representative, balance, timestamp    // Account to head block, representative, balance, last_change
 	MDB_dbi accounts;
-	// block_hash -> send_block
-	MDB_dbi send_blocks;
-	// block_hash -> receive_block
-	MDB_dbi receive_blocks;
-	// block_hash -> open_block
-	MDB_dbi open_blocks;
-	// block_hash -> change_block
-	MDB_dbi change_blocks;
-	// block_hash -> state_block
-	MDB_dbi state_blocks;
+	// block_hash -> block_type, block, successor, account, height, balance // All blocks with their ledger sideband
+	MDB_dbi blocks;
 	// block_hash -> sender, amount, destination                    // Pending blocks to sender account, amount, destination account
 	MDB_dbi pending;
+	// (representative, account) -> balance                         // Accounts delegating to each representative
+	MDB_dbi delegators;
 	// block_hash -> account, balance                               // Blocks info
 	MDB_dbi blocks_info;
 	// account -> weight                                            // Representation
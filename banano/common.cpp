@@ -264,7 +264,8 @@ rai::block_counts::block_counts () :
 send (0),
 receive (0),
 open (0),
-change (0)
+change (0),
+state (0)
 {
 }
 
@@ -402,6 +403,50 @@ rai::mdb_val rai::block_info::val () const
 	return rai::mdb_val (sizeof (*this), const_cast<rai::block_info *> (this));
 }
 
+size_t constexpr rai::block_sideband::size;
+
+rai::block_sideband::block_sideband () :
+successor (0),
+account (0),
+height (0),
+balance (0)
+{
+}
+
+rai::block_sideband::block_sideband (rai::block_hash const & successor_a, rai::account const & account_a, uint64_t height_a, rai::amount const & balance_a) :
+successor (successor_a),
+account (account_a),
+height (height_a),
+balance (balance_a)
+{
+}
+
+void rai::block_sideband::serialize (rai::stream & stream_a) const
+{
+	rai::write (stream_a, successor.bytes);
+	rai::write (stream_a, account.bytes);
+	rai::write (stream_a, height);
+	rai::write (stream_a, balance.bytes);
+}
+
+bool rai::block_sideband::deserialize (rai::stream & stream_a)
+{
+	auto error (rai::read (stream_a, successor.bytes));
+	if (!error)
+	{
+		error = rai::read (stream_a, account.bytes);
+		if (!error)
+		{
+			error = rai::read (stream_a, height);
+			if (!error)
+			{
+				error = rai::read (stream_a, balance.bytes);
+			}
+		}
+	}
+	return error;
+}
+
 bool rai::vote::operator== (rai::vote const & other_a) const
 {
 	return sequence == other_a.sequence && *block == *other_a.block && account == other_a.account && signature == other_a.signature;
@@ -729,9 +774,10 @@ void rai::genesis::initialize (MDB_txn * transaction_a, rai::block_store & store
 {
 	auto hash_l (hash ());
 	assert (store_a.latest_begin (transaction_a) == store_a.latest_end ());
-	store_a.block_put (transaction_a, hash_l, *open);
+	store_a.block_put (transaction_a, hash_l, *open, rai::block_sideband (0, rai::genesis_account, 1, rai::genesis_amount));
 	store_a.account_put (transaction_a, genesis_account, { hash_l, open->hash (), open->hash (), std::numeric_limits<rai::uint128_t>::max (), rai::seconds_since_epoch (), 1 });
 	store_a.representation_put (transaction_a, genesis_account, std::numeric_limits<rai::uint128_t>::max ());
+	store_a.delegator_put (transaction_a, genesis_account, genesis_account, std::numeric_limits<rai::uint128_t>::max ());
 	store_a.checksum_put (transaction_a, 0, 0, hash_l);
 	store_a.frontier_put (transaction_a, hash_l, genesis_account);
 }
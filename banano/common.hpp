@@ -168,6 +168,22 @@ public:
 	rai::account account;
 	rai::amount balance;
 };
+/**
+ * Ledger information stored after each block in the blocks table
+ */
+class block_sideband
+{
+public:
+	block_sideband ();
+	block_sideband (rai::block_hash const &, rai::account const &, uint64_t, rai::amount const &);
+	void serialize (rai::stream &) const;
+	bool deserialize (rai::stream &);
+	rai::block_hash successor;
+	rai::account account;
+	uint64_t height;
+	rai::amount balance;
+	static size_t constexpr size = sizeof (rai::block_hash) + sizeof (rai::account) + sizeof (uint64_t) + sizeof (rai::amount);
+};
 class block_counts
 {
 public:
@@ -232,6 +248,12 @@ enum class process_result
 	balance_mismatch, // Balance and amount delta don't match
 	block_position // This block cannot follow the previous block
 };
+enum class signature_verification
+{
+	unknown, // Signature has not been checked, the ledger must validate it
+	invalid, // Signature was checked and is bad
+	valid // Signature was checked against the block's own account before reaching the ledger
+};
 class process_return
 {
 public:
@@ -35,6 +35,23 @@ TEST (transaction_block, empty)
 	ASSERT_TRUE (rai::validate_message (key1.pub, hash, block.signature));
 }
 
+TEST (block, full_hash)
+{
+	rai::keypair key1;
+	rai::send_block block1 (0, 1, 2, key1.prv, 4, 5);
+	rai::send_block block2 (block1);
+	ASSERT_EQ (block1.full_hash (), block2.full_hash ());
+	ASSERT_NE (block1.hash (), block1.full_hash ());
+	// Signature and work aren't part of the hash but are part of the full hash
+	block2.signature.bytes[0] ^= 1;
+	ASSERT_EQ (block1.hash (), block2.hash ());
+	ASSERT_NE (block1.full_hash (), block2.full_hash ());
+	rai::send_block block3 (block1);
+	block3.block_work_set (6);
+	ASSERT_EQ (block1.hash (), block3.hash ());
+	ASSERT_NE (block1.full_hash (), block3.full_hash ());
+}
+
 TEST (block, send_serialize)
 {
 	rai::send_block block1 (0, 1, 2, rai::keypair ().prv, 4, 5);
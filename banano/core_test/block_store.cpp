@@ -226,6 +226,40 @@ TEST (unchecked, double_put)
 	ASSERT_EQ (block3.size (), 1);
 }
 
+TEST (unchecked, release)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	auto block1 (std::make_shared<rai::send_block> (4, 1, 2, rai::keypair ().prv, 4, 5));
+	auto block2 (std::make_shared<rai::send_block> (block1->hash (), 1, 2, rai::keypair ().prv, 4, 5));
+	auto block3 (std::make_shared<rai::send_block> (5, 1, 2, rai::keypair ().prv, 4, 5));
+	rai::transaction transaction (store.environment, nullptr, true);
+	store.unchecked_put (transaction, block1->previous (), block1);
+	store.unchecked_put (transaction, block2->previous (), block2);
+	store.unchecked_put (transaction, block3->previous (), block3);
+	// Spilled entries are released along with those in memory
+	store.flush (transaction);
+	auto block4 (std::make_shared<rai::send_block> (block2->hash (), 1, 2, rai::keypair ().prv, 4, 5));
+	store.unchecked_put (transaction, block4->previous (), block4);
+	ASSERT_EQ (4, store.unchecked_count (transaction));
+	// Only the direct dependents are released, the rest wait until those have been processed
+	auto released1 (store.unchecked_release (transaction, block1->previous ()));
+	ASSERT_EQ (1, released1.size ());
+	ASSERT_EQ (*block1, *released1[0].second);
+	ASSERT_EQ (block1->previous (), released1[0].first);
+	ASSERT_EQ (3, store.unchecked_count (transaction));
+	auto released2 (store.unchecked_release (transaction, block1->hash ()));
+	ASSERT_EQ (1, released2.size ());
+	ASSERT_EQ (*block2, *released2[0].second);
+	auto released3 (store.unchecked_release (transaction, block2->hash ()));
+	ASSERT_EQ (1, released3.size ());
+	ASSERT_EQ (*block4, *released3[0].second);
+	ASSERT_EQ (1, store.unchecked_count (transaction));
+	ASSERT_TRUE (store.unchecked_get (transaction, block1->hash ()).empty ());
+	ASSERT_FALSE (store.unchecked_get (transaction, block3->previous ()).empty ());
+}
+
 TEST (checksum, simple)
 {
 	bool init (false);
@@ -574,6 +608,39 @@ TEST (block_store, block_replace)
 	auto block3 (store.block_get (transaction, 0));
 	ASSERT_NE (nullptr, block3);
 	ASSERT_EQ (2, block3->block_work ());
+	ASSERT_EQ (1, store.block_count (transaction).send);
+}
+
+TEST (block_store, block_sideband)
+{
+	bool init (false);
+	rai::block_store store (init, rai::unique_path ());
+	ASSERT_TRUE (!init);
+	rai::genesis genesis;
+	rai::transaction transaction (store.environment, nullptr, true);
+	genesis.initialize (transaction, store);
+	rai::ledger ledger (store);
+	rai::keypair key1;
+	rai::send_block send1 (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0);
+	ASSERT_EQ (rai::process_result::progress, ledger.process (transaction, send1).code);
+	rai::block_sideband sideband1;
+	ASSERT_NE (nullptr, store.block_get (transaction, genesis.hash (), &sideband1));
+	ASSERT_EQ (send1.hash (), sideband1.successor);
+	ASSERT_EQ (rai::genesis_account, sideband1.account);
+	ASSERT_EQ (1, sideband1.height);
+	ASSERT_EQ (rai::genesis_amount, sideband1.balance.number ());
+	rai::block_sideband sideband2;
+	ASSERT_NE (nullptr, store.block_get (transaction, send1.hash (), &sideband2));
+	ASSERT_TRUE (sideband2.successor.is_zero ());
+	ASSERT_EQ (rai::genesis_account, sideband2.account);
+	ASSERT_EQ (2, sideband2.height);
+	ASSERT_EQ (rai::genesis_amount - 100, sideband2.balance.number ());
+	ASSERT_EQ (rai::genesis_account, ledger.account (transaction, send1.hash ()));
+	auto count (store.block_count (transaction));
+	ASSERT_EQ (1, count.open);
+	ASSERT_EQ (1, count.send);
+	store.block_del (transaction, send1.hash ());
+	ASSERT_EQ (0, store.block_count (transaction).send);
 }
 
 TEST (block_store, block_count)
@@ -588,6 +655,30 @@ TEST (block_store, block_count)
 	ASSERT_EQ (1, store.block_count (rai::transaction (store.environment, nullptr, false)).sum ());
 }
 
+TEST (block_store, block_count_persistence)
+{
+	auto path (rai::unique_path ());
+	rai::open_block block (0, 1, 0, rai::keypair ().prv, 0, 0);
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		rai::genesis genesis;
+		genesis.initialize (transaction, store);
+		store.block_put (transaction, block.hash (), block);
+		ASSERT_EQ (2, store.block_count (transaction).open);
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, true);
+	ASSERT_EQ (2, store.block_count (transaction).open);
+	store.block_del (transaction, block.hash ());
+	ASSERT_EQ (1, store.block_count (transaction).open);
+	ASSERT_EQ (1, store.block_count (transaction).sum ());
+}
+
 TEST (block_store, frontier_count)
 {
 	bool init (false);
@@ -987,3 +1078,34 @@ TEST (block_store, state_block)
 	auto count2 (store.block_count (transaction));
 	ASSERT_EQ (0, count2.state);
 }
+
+TEST (block_store, representation_cache)
+{
+	auto path (rai::unique_path ());
+	rai::keypair key1;
+	{
+		bool init (false);
+		rai::block_store store (init, path);
+		ASSERT_FALSE (init);
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.representation_put (transaction, key1.pub, 100);
+		ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+		ASSERT_EQ (1, store.representation_cache.weights.size ());
+	}
+	bool init (false);
+	rai::block_store store (init, path);
+	ASSERT_FALSE (init);
+	rai::transaction transaction (store.environment, nullptr, true);
+	ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+	rai::keypair key2;
+	store.representation_put (transaction, key2.pub, 200);
+	auto weights (store.representation_cache.list ());
+	ASSERT_EQ (2, weights.size ());
+	ASSERT_LT (weights[0].first, weights[1].first);
+	ASSERT_EQ (key1.pub < key2.pub ? 100 : 200, weights[0].second);
+	store.representation_put (transaction, key1.pub, 0);
+	store.representation_put (transaction, key2.pub, 0);
+	ASSERT_EQ (0, store.representation_get (transaction, key1.pub));
+	ASSERT_TRUE (store.representation_cache.weights.empty ());
+	ASSERT_TRUE (store.representation_cache.list ().empty ());
+}
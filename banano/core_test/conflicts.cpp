@@ -76,6 +76,39 @@ TEST (conflicts, add_two)
 	ASSERT_EQ (2, node1.active.roots.size ());
 }
 
+TEST (conflicts, priority)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - rai::kBAN_ratio, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send1).code);
+	rai::keypair key2;
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key2.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	ASSERT_EQ (rai::process_result::progress, node1.process (*send2).code);
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		node1.active.start (transaction, send1);
+		node1.active.start (transaction, send2);
+	}
+	std::lock_guard<std::mutex> lock (node1.active.mutex);
+	auto info1 (*node1.active.roots.find (send1->root ()));
+	auto info2 (*node1.active.roots.find (send2->root ()));
+	ASSERT_EQ (rai::genesis_amount - rai::kBAN_ratio, info1.election->balance.number ());
+	ASSERT_TRUE (info2.election->balance.is_zero ());
+	auto now (std::chrono::steady_clock::now ());
+	// Same age and progress, the larger balance goes first
+	info2.election->start = info1.election->start;
+	ASSERT_GT (node1.active.priority (info1, now), node1.active.priority (info2, now));
+	// Elections further through their announcements outrank any balance
+	info2.announcements = 1;
+	ASSERT_GT (node1.active.priority (info2, now), node1.active.priority (info1, now));
+	// Confirmed elections are announced last
+	info2.election->confirmed = true;
+	ASSERT_GT (node1.active.priority (info1, now), node1.active.priority (info2, now));
+}
+
 TEST (votes, contested)
 {
 	rai::genesis genesis;
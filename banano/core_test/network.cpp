@@ -52,9 +52,11 @@ TEST (network, construction)
 TEST (network, self_discard)
 {
 	rai::system system (24000, 1);
-	system.nodes[0]->network.remote = system.nodes[0]->network.endpoint ();
+	rai::udp_data data;
+	data.endpoint = system.nodes[0]->network.endpoint ();
+	data.size = 0;
 	ASSERT_EQ (0, system.nodes[0]->network.bad_sender_count);
-	system.nodes[0]->network.receive_action (boost::system::error_code{}, 0);
+	system.nodes[0]->network.receive_action (&data);
 	ASSERT_EQ (1, system.nodes[0]->network.bad_sender_count);
 }
 
@@ -165,6 +167,34 @@ TEST (network, send_discarded_publish)
 	ASSERT_EQ (genesis.hash (), system.nodes[1]->latest (rai::test_genesis_key.pub));
 }
 
+TEST (network, publish_filter_dropped)
+{
+	rai::system system (24000, 2);
+	auto & node1 (*system.nodes[1]);
+	// Nothing is drained once the processor is stopped
+	node1.block_processor.stop ();
+	auto filler (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, 0));
+	ASSERT_FALSE (node1.block_processor.add (std::vector<std::shared_ptr<rai::block>> (rai::block_processor::queue_max, filler), rai::block_origin::live));
+	auto block (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, system.work.generate (1)));
+	for (auto i (1); i <= 2; ++i)
+	{
+		{
+			rai::transaction transaction (system.nodes[0]->store.environment, nullptr, false);
+			system.nodes[0]->network.republish_block (transaction, block);
+		}
+		auto iterations (0);
+		while (node1.network.incoming.publish < i)
+		{
+			system.poll ();
+			++iterations;
+			ASSERT_LT (iterations, 200);
+		}
+		// The rebroadcast isn't filtered since the first arrival was dropped by the full queue
+		ASSERT_EQ (i, node1.block_processor.dropped[static_cast<size_t> (rai::block_origin::live)]);
+	}
+	ASSERT_FALSE (node1.publish_filter.apply (block->full_hash ()));
+}
+
 TEST (network, send_invalid_publish)
 {
 	rai::system system (24000, 2);
@@ -464,11 +494,11 @@ TEST (bulk_pull, none)
 	req->end = genesis.hash ();
 	connection->requests.push (std::unique_ptr<rai::message>{});
 	auto request (std::make_shared<rai::bulk_pull_server> (connection, std::move (req)));
-	auto block (request->get_next ());
-	ASSERT_EQ (nullptr, block);
+	ASSERT_EQ (0, request->fill_batch ());
+	ASSERT_TRUE (request->send_buffer.empty ());
 }
 
-TEST (bulk_pull, get_next_on_open)
+TEST (bulk_pull, fill_batch_on_open)
 {
 	rai::system system (24000, 1);
 	auto connection (std::make_shared<rai::bootstrap_server> (nullptr, system.nodes[0]));
@@ -477,13 +507,201 @@ TEST (bulk_pull, get_next_on_open)
 	req->end.clear ();
 	connection->requests.push (std::unique_ptr<rai::message>{});
 	auto request (std::make_shared<rai::bulk_pull_server> (connection, std::move (req)));
-	auto block (request->get_next ());
+	ASSERT_EQ (1, request->fill_batch ());
+	rai::bufferstream stream (request->send_buffer.data (), request->send_buffer.size ());
+	auto block (rai::deserialize_block (stream));
 	ASSERT_NE (nullptr, block);
 	ASSERT_TRUE (block->previous ().is_zero ());
 	ASSERT_FALSE (connection->requests.empty ());
 	ASSERT_EQ (request->current, request->request->end);
 }
 
+TEST (bulk_pull, fill_batch)
+{
+	rai::system system (24000, 1);
+	rai::keypair key2;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (rai::test_genesis_key.pub, key2.pub, 100));
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (rai::test_genesis_key.pub, key2.pub, 100));
+	auto connection (std::make_shared<rai::bootstrap_server> (nullptr, system.nodes[0]));
+	std::unique_ptr<rai::bulk_pull> req (new rai::bulk_pull{});
+	req->start = rai::test_genesis_key.pub;
+	req->end.clear ();
+	connection->requests.push (std::unique_ptr<rai::message>{});
+	auto request (std::make_shared<rai::bulk_pull_server> (connection, std::move (req)));
+	auto latest (system.nodes[0]->latest (rai::test_genesis_key.pub));
+	ASSERT_EQ (3, request->fill_batch ());
+	ASSERT_EQ (request->current, request->request->end);
+	rai::bufferstream stream (request->send_buffer.data (), request->send_buffer.size ());
+	auto block1 (rai::deserialize_block (stream));
+	ASSERT_NE (nullptr, block1);
+	ASSERT_EQ (latest, block1->hash ());
+	auto block2 (rai::deserialize_block (stream));
+	ASSERT_NE (nullptr, block2);
+	ASSERT_EQ (block1->previous (), block2->hash ());
+	auto block3 (rai::deserialize_block (stream));
+	ASSERT_NE (nullptr, block3);
+	ASSERT_EQ (rai::genesis ().hash (), block3->hash ());
+	ASSERT_EQ (0, request->fill_batch ());
+}
+
+TEST (bulk_pull, decode_blocks)
+{
+	rai::system system (24000, 1);
+	rai::keypair key2;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (rai::test_genesis_key.pub, key2.pub, 100));
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (rai::test_genesis_key.pub, key2.pub, 100));
+	// The genesis chain newest first as it's sent by bulk_pull_server
+	std::vector<std::vector<uint8_t>> serialized;
+	auto latest (system.nodes[0]->latest (rai::test_genesis_key.pub));
+	{
+		rai::transaction transaction (system.nodes[0]->store.environment, nullptr, false);
+		for (auto hash (latest); !hash.is_zero ();)
+		{
+			auto block (system.nodes[0]->store.block_get (transaction, hash));
+			ASSERT_NE (nullptr, block);
+			serialized.push_back (std::vector<uint8_t> ());
+			rai::vectorstream stream (serialized.back ());
+			rai::serialize_block (stream, *block);
+			hash = block->previous ();
+		}
+	}
+	ASSERT_EQ (3, serialized.size ());
+	auto attempt (std::make_shared<rai::bootstrap_attempt> (system.nodes[0]));
+	auto client (std::make_shared<rai::bootstrap_client> (system.nodes[0], attempt, rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24001)));
+	uint8_t not_a_block (static_cast<uint8_t> (rai::block_type::not_a_block));
+	rai::block_hash remaining;
+	{
+		auto pull (std::make_shared<rai::bulk_pull_client> (client, rai::pull_info (rai::test_genesis_key.pub, latest, 0)));
+		pull->expected = latest;
+		std::vector<std::shared_ptr<rai::block>> blocks;
+		// Half a block is kept for the next read
+		auto half (serialized[0].size () / 2);
+		pull->receive_buffer.assign (serialized[0].begin (), serialized[0].begin () + half);
+		pull->receive_size = half;
+		ASSERT_FALSE (pull->decode_blocks (blocks));
+		ASSERT_TRUE (blocks.empty ());
+		ASSERT_EQ (half, pull->receive_size);
+		// The rest of it arrives together with the next block
+		pull->receive_buffer.insert (pull->receive_buffer.end (), serialized[0].begin () + half, serialized[0].end ());
+		pull->receive_buffer.insert (pull->receive_buffer.end (), serialized[1].begin (), serialized[1].end ());
+		pull->receive_size = pull->receive_buffer.size ();
+		ASSERT_FALSE (pull->decode_blocks (blocks));
+		ASSERT_EQ (2, blocks.size ());
+		ASSERT_EQ (latest, blocks[0]->hash ());
+		ASSERT_EQ (blocks[0]->previous (), blocks[1]->hash ());
+		ASSERT_EQ (0, pull->receive_size);
+		ASSERT_FALSE (pull->finished);
+		pull->receive_buffer.assign (serialized[2].begin (), serialized[2].end ());
+		pull->receive_buffer.push_back (not_a_block);
+		pull->receive_size = pull->receive_buffer.size ();
+		ASSERT_TRUE (pull->decode_blocks (blocks));
+		ASSERT_EQ (3, blocks.size ());
+		ASSERT_EQ (rai::genesis ().hash (), blocks[2]->hash ());
+		ASSERT_EQ (0, pull->receive_size);
+		ASSERT_TRUE (pull->finished);
+		ASSERT_EQ (pull->pull.end, pull->expected);
+	}
+	{
+		auto pull (std::make_shared<rai::bulk_pull_client> (client, rai::pull_info (rai::test_genesis_key.pub, latest, 0)));
+		pull->expected = latest;
+		std::vector<std::shared_ptr<rai::block>> blocks;
+		// Bytes after not_a_block aren't decoded
+		pull->receive_buffer.assign (serialized[0].begin (), serialized[0].end ());
+		pull->receive_buffer.push_back (not_a_block);
+		pull->receive_buffer.insert (pull->receive_buffer.end (), serialized[1].begin (), serialized[1].end ());
+		pull->receive_size = pull->receive_buffer.size ();
+		ASSERT_TRUE (pull->decode_blocks (blocks));
+		ASSERT_EQ (1, blocks.size ());
+		ASSERT_EQ (latest, blocks[0]->hash ());
+		ASSERT_TRUE (pull->finished);
+		ASSERT_EQ (serialized[1].size (), pull->receive_size);
+		remaining = blocks[0]->previous ();
+	}
+	// Cut short, so the rest of the pull is queued again
+	ASSERT_EQ (1, attempt->pulls.size ());
+	ASSERT_EQ (remaining, attempt->pulls.front ().head);
+}
+
+TEST (bulk_pull, dropped_requeue)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key2;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	auto send1 (system.wallet (0)->send_action (rai::test_genesis_key.pub, key2.pub, 100));
+	ASSERT_NE (nullptr, send1);
+	auto send2 (system.wallet (0)->send_action (rai::test_genesis_key.pub, key2.pub, 100));
+	ASSERT_NE (nullptr, send2);
+	// The two newest blocks of the genesis chain arrive in one read
+	std::vector<uint8_t> serialized;
+	{
+		rai::vectorstream stream (serialized);
+		rai::serialize_block (stream, *send2);
+		rai::serialize_block (stream, *send1);
+	}
+	// Leave room for one block in the bootstrap queue
+	node1.block_processor.stop ();
+	auto filler (std::make_shared<rai::send_block> (1, 1, 2, rai::keypair ().prv, 4, 0));
+	ASSERT_FALSE (node1.block_processor.add (std::vector<std::shared_ptr<rai::block>> (rai::block_processor::queue_max - 1, filler), rai::block_origin::bootstrap));
+	auto attempt (std::make_shared<rai::bootstrap_attempt> (system.nodes[0]));
+	auto client (std::make_shared<rai::bootstrap_client> (system.nodes[0], attempt, rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24001)));
+	// Nothing is read after this
+	client->hard_stop = true;
+	{
+		auto pull (std::make_shared<rai::bulk_pull_client> (client, rai::pull_info (rai::test_genesis_key.pub, send2->hash (), 0)));
+		pull->expected = send2->hash ();
+		pull->receive_buffer = serialized;
+		pull->received_data (boost::system::error_code (), serialized.size ());
+		ASSERT_EQ (1, pull->pull_blocks);
+		ASSERT_EQ (1, node1.block_processor.dropped[static_cast<size_t> (rai::block_origin::bootstrap)]);
+	}
+	// The cut short pull continues from the genesis block, and the chain is pulled again down to the dropped block
+	ASSERT_EQ (2, attempt->pulls.size ());
+	ASSERT_EQ (send1->previous (), attempt->pulls[0].head);
+	ASSERT_EQ (send2->hash (), attempt->pulls[1].head);
+	ASSERT_EQ (send1->previous (), attempt->pulls[1].end);
+}
+
+TEST (bulk_pull, client_requeue)
+{
+	rai::system system (24000, 1);
+	auto attempt (std::make_shared<rai::bootstrap_attempt> (system.nodes[0]));
+	auto client (std::make_shared<rai::bootstrap_client> (system.nodes[0], attempt, rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24001)));
+	rai::keypair key1;
+	rai::keypair key2;
+	rai::keypair key3;
+	{
+		auto pull (std::make_shared<rai::bulk_pull_client> (client, rai::pull_info (key1.pub, 1, 0)));
+		// Cut short before reaching the end of the pull
+		pull->expected = 1;
+		pull->batch.push_back (rai::pull_info (key2.pub, 2, 0));
+		pull->batch.push_back (rai::pull_info (key3.pub, 3, 0));
+	}
+	// The current pull is retried first and the pulls which never started are returned as they were
+	ASSERT_EQ (3, attempt->pulls.size ());
+	ASSERT_EQ (key1.pub, attempt->pulls[0].account);
+	ASSERT_EQ (1, attempt->pulls[0].attempts);
+	ASSERT_EQ (key2.pub, attempt->pulls[1].account);
+	ASSERT_EQ (0, attempt->pulls[1].attempts);
+	ASSERT_EQ (key3.pub, attempt->pulls[2].account);
+	ASSERT_EQ (0, attempt->pulls[2].attempts);
+	attempt->pulls.clear ();
+	{
+		auto original (std::make_shared<rai::bulk_pull_client> (client, rai::pull_info (key1.pub, 1, 0)));
+		original->expected = 1;
+		auto duplicate (std::make_shared<rai::bulk_pull_client> (client, rai::pull_info (key1.pub, 1, 0)));
+		duplicate->expected = 1;
+		duplicate->speculative = true;
+		duplicate->original = original;
+		// The duplicate completed the pull first
+		original->superseded = true;
+	}
+	// Neither the superseded original nor the speculative duplicate are retried
+	ASSERT_TRUE (attempt->pulls.empty ());
+}
+
 TEST (bootstrap_processor, DISABLED_process_none)
 {
 	rai::system system (24000, 1);
@@ -693,6 +911,83 @@ TEST (bootstrap_processor, push_one)
 	node1->stop ();
 }
 
+// Frontiers arriving in chunks are merged against accounts the puller already has
+TEST (bootstrap_processor, frontiers_many)
+{
+	rai::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	rai::node_init init1;
+	auto node1 (std::make_shared<rai::node> (init1, system.service, 24001, rai::unique_path (), system.alarm, system.logging, system.work));
+	ASSERT_FALSE (init1.error ());
+	std::vector<rai::keypair> keys (32);
+	auto latest (node0->latest (rai::test_genesis_key.pub));
+	auto balance (rai::genesis_amount);
+	for (size_t i (0); i < keys.size (); ++i)
+	{
+		balance -= 1;
+		rai::send_block send (latest, keys[i].pub, balance, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (latest));
+		rai::open_block open (send.hash (), keys[i].pub, keys[i].pub, keys[i].prv, keys[i].pub, system.work.generate (keys[i].pub));
+		ASSERT_EQ (rai::process_result::progress, node0->process (send).code);
+		ASSERT_EQ (rai::process_result::progress, node0->process (open).code);
+		ASSERT_EQ (rai::process_result::progress, node1->process (send).code);
+		// Every other account is already known to the puller
+		if (i % 2 == 0)
+		{
+			ASSERT_EQ (rai::process_result::progress, node1->process (open).code);
+		}
+		latest = send.hash ();
+	}
+	// The genesis frontier is ahead on the peer
+	rai::send_block send (latest, keys[0].pub, balance - 1, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (latest));
+	ASSERT_EQ (rai::process_result::progress, node0->process (send).code);
+	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
+	auto iterations (0);
+	while (std::any_of (keys.begin (), keys.end (), [&node1](rai::keypair const & key_a) { return node1->balance (key_a.pub) != 1; }))
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (node0->latest (rai::test_genesis_key.pub), node1->latest (rai::test_genesis_key.pub));
+	node1->stop ();
+}
+
+TEST (bootstrap_processor, pull_batch)
+{
+	rai::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	rai::node_init init1;
+	auto node1 (std::make_shared<rai::node> (init1, system.service, 24001, rai::unique_path (), system.alarm, system.logging, system.work));
+	ASSERT_FALSE (init1.error ());
+	// More accounts than connections so fresh pulls are batched on each connection
+	std::vector<rai::keypair> keys (48);
+	auto latest (node0->latest (rai::test_genesis_key.pub));
+	auto balance (rai::genesis_amount);
+	for (auto & key : keys)
+	{
+		balance -= 1;
+		rai::send_block send (latest, key.pub, balance, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (latest));
+		rai::open_block open (send.hash (), key.pub, key.pub, key.prv, key.pub, system.work.generate (key.pub));
+		ASSERT_EQ (rai::process_result::progress, node0->process (send).code);
+		ASSERT_EQ (rai::process_result::progress, node0->process (open).code);
+		latest = send.hash ();
+	}
+	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
+	auto iterations (0);
+	while (std::any_of (keys.begin (), keys.end (), [&node1](rai::keypair const & key_a) { return node1->balance (key_a.pub) != 1; }))
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (node0->latest (rai::test_genesis_key.pub), node1->latest (rai::test_genesis_key.pub));
+	// Every account was pulled from the one peer
+	auto scores (node1->bootstrap_initiator.peer_scores.list ());
+	ASSERT_EQ (1, scores.size ());
+	ASSERT_LE (keys.size () + 1, scores[0].second.pulls);
+	node1->stop ();
+}
+
 TEST (frontier_req_response, DISABLED_destruction)
 {
 	{
@@ -767,6 +1062,36 @@ TEST (frontier_req, time_cutoff)
 	ASSERT_EQ (genesis.hash (), request->info.head);
 }
 
+TEST (frontier_req, batch)
+{
+	rai::system system (24000, 1);
+	rai::keypair key1;
+	rai::genesis genesis;
+	rai::send_block send1 (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (genesis.hash ()));
+	rai::open_block open1 (send1.hash (), key1.pub, key1.pub, key1.prv, key1.pub, system.work.generate (key1.pub));
+	{
+		rai::transaction transaction (system.nodes[0]->store.environment, nullptr, true);
+		ASSERT_EQ (rai::process_result::progress, system.nodes[0]->ledger.process (transaction, send1).code);
+		ASSERT_EQ (rai::process_result::progress, system.nodes[0]->ledger.process (transaction, open1).code);
+	}
+	auto connection (std::make_shared<rai::bootstrap_server> (nullptr, system.nodes[0]));
+	std::unique_ptr<rai::frontier_req> req (new rai::frontier_req);
+	req->start.clear ();
+	req->age = std::numeric_limits<decltype (req->age)>::max ();
+	req->count = std::numeric_limits<decltype (req->count)>::max ();
+	connection->requests.push (std::unique_ptr<rai::message>{});
+	auto request (std::make_shared<rai::frontier_req_server> (connection, std::move (req)));
+	// Both frontiers go out in one buffer, in account order
+	ASSERT_EQ (2, request->fill_batch ());
+	ASSERT_EQ (4 * sizeof (rai::uint256_union), request->send_buffer.size ());
+	auto first (std::min (key1.pub, rai::test_genesis_key.pub));
+	rai::account account;
+	std::copy (request->send_buffer.begin (), request->send_buffer.begin () + sizeof (account), account.bytes.begin ());
+	ASSERT_EQ (first, account);
+	ASSERT_TRUE (request->current.is_zero ());
+	ASSERT_EQ (0, request->fill_batch ());
+}
+
 TEST (bulk, genesis)
 {
 	rai::system system (24000, 1);
@@ -925,3 +1250,50 @@ TEST (node, port_mapping)
 		system.poll ();
 	}
 }
+
+TEST (udp_buffer, one)
+{
+	rai::message_statistics stats;
+	rai::udp_buffer buffer (stats, 512, 1);
+	auto buffer1 (buffer.allocate ());
+	ASSERT_NE (nullptr, buffer1);
+	buffer.enqueue (buffer1);
+	std::vector<rai::udp_data *> batch;
+	ASSERT_TRUE (buffer.dequeue (batch, 4));
+	ASSERT_EQ (1, batch.size ());
+	ASSERT_EQ (buffer1, batch[0]);
+	buffer.release (buffer1);
+	ASSERT_EQ (buffer1, buffer.allocate ());
+	ASSERT_EQ (1, stats.packets);
+	ASSERT_EQ (1, stats.batches);
+}
+
+TEST (udp_buffer, overflow)
+{
+	rai::message_statistics stats;
+	rai::udp_buffer buffer (stats, 512, 2);
+	auto buffer1 (buffer.allocate ());
+	auto buffer2 (buffer.allocate ());
+	ASSERT_NE (buffer1, buffer2);
+	buffer.enqueue (buffer1);
+	buffer.enqueue (buffer2);
+	// No free buffers, the oldest queued datagram is recycled
+	ASSERT_EQ (buffer1, buffer.allocate ());
+	ASSERT_EQ (1, stats.dropped);
+	std::vector<rai::udp_data *> batch;
+	ASSERT_TRUE (buffer.dequeue (batch, 4));
+	ASSERT_EQ (1, batch.size ());
+	ASSERT_EQ (buffer2, batch[0]);
+	ASSERT_EQ (2, stats.packets);
+	ASSERT_EQ (1, stats.batch_packets);
+}
+
+TEST (udp_buffer, stop)
+{
+	rai::message_statistics stats;
+	rai::udp_buffer buffer (stats, 512, 2);
+	buffer.stop ();
+	ASSERT_EQ (nullptr, buffer.allocate ());
+	std::vector<rai::udp_data *> batch;
+	ASSERT_FALSE (buffer.dequeue (batch, 4));
+}
@@ -514,6 +514,14 @@ TEST (node_config, serialization)
 	config1.lmdb_max_dbs = 256;
 	config1.state_block_parse_canary = 10;
 	config1.state_block_generate_canary = 10;
+	config1.signature_checker_threads = 257;
+	config1.network_threads = 259;
+	config1.block_processor_batch_max_blocks = 260;
+	config1.block_processor_batch_max_time = std::chrono::milliseconds (261);
+	config1.lmdb_sync_interval = std::chrono::milliseconds (262);
+	config1.election_announce_budget = 263;
+	config1.election_broadcast_batch = 264;
+	config1.vote_processor_threads = 265;
 	boost::property_tree::ptree tree;
 	config1.serialize_json (tree);
 	rai::logging logging2;
@@ -532,6 +540,14 @@ TEST (node_config, serialization)
 	ASSERT_NE (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
 	ASSERT_NE (config2.state_block_parse_canary, config1.state_block_parse_canary);
 	ASSERT_NE (config2.state_block_generate_canary, config1.state_block_generate_canary);
+	ASSERT_NE (config2.signature_checker_threads, config1.signature_checker_threads);
+	ASSERT_NE (config2.network_threads, config1.network_threads);
+	ASSERT_NE (config2.block_processor_batch_max_blocks, config1.block_processor_batch_max_blocks);
+	ASSERT_NE (config2.block_processor_batch_max_time, config1.block_processor_batch_max_time);
+	ASSERT_NE (config2.lmdb_sync_interval, config1.lmdb_sync_interval);
+	ASSERT_NE (config2.election_announce_budget, config1.election_announce_budget);
+	ASSERT_NE (config2.election_broadcast_batch, config1.election_broadcast_batch);
+	ASSERT_NE (config2.vote_processor_threads, config1.vote_processor_threads);
 
 	bool upgraded (false);
 	config2.deserialize_json (upgraded, tree);
@@ -548,6 +564,14 @@ TEST (node_config, serialization)
 	ASSERT_EQ (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
 	ASSERT_EQ (config2.state_block_parse_canary, config1.state_block_parse_canary);
 	ASSERT_EQ (config2.state_block_generate_canary, config1.state_block_generate_canary);
+	ASSERT_EQ (config2.signature_checker_threads, config1.signature_checker_threads);
+	ASSERT_EQ (config2.network_threads, config1.network_threads);
+	ASSERT_EQ (config2.block_processor_batch_max_blocks, config1.block_processor_batch_max_blocks);
+	ASSERT_EQ (config2.block_processor_batch_max_time, config1.block_processor_batch_max_time);
+	ASSERT_EQ (config2.lmdb_sync_interval, config1.lmdb_sync_interval);
+	ASSERT_EQ (config2.election_announce_budget, config1.election_announce_budget);
+	ASSERT_EQ (config2.election_broadcast_batch, config1.election_broadcast_batch);
+	ASSERT_EQ (config2.vote_processor_threads, config1.vote_processor_threads);
 }
 
 TEST (node_config, v1_v2_upgrade)
@@ -1475,3 +1499,165 @@ TEST (node, online_reps)
 		ASSERT_LT (iterations, 200);
 	}
 }
+
+TEST (node, block_processor_signatures)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key1;
+	rai::genesis genesis;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, 0, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	auto open1 (std::make_shared<rai::open_block> (send1->hash (), 1, key1.pub, key1.prv, key1.pub, system.work.generate (key1.pub)));
+	auto signature (open1->block_signature ());
+	signature.bytes[32] ^= 0x1;
+	open1->signature_set (signature);
+	node1.block_processor.add (send1);
+	node1.block_processor.add (open1);
+	node1.block_processor.flush ();
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_TRUE (node1.store.block_exists (transaction, send1->hash ()));
+	ASSERT_FALSE (node1.store.block_exists (transaction, open1->hash ()));
+}
+
+TEST (node, block_processor_batch_max_blocks)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	node1.config.block_processor_batch_max_blocks = 1;
+	rai::keypair key1;
+	rai::genesis genesis;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	auto send2 (std::make_shared<rai::send_block> (send1->hash (), key1.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (send1->hash ())));
+	auto batches (node1.block_processor.batches.load ());
+	node1.block_processor.add (send1);
+	node1.block_processor.add (send2);
+	node1.block_processor.flush ();
+	ASSERT_LE (batches + 2, node1.block_processor.batches.load ());
+	ASSERT_EQ (1, node1.block_processor.batch_size.load ());
+	rai::transaction transaction (node1.store.environment, nullptr, false);
+	ASSERT_TRUE (node1.store.block_exists (transaction, send2->hash ()));
+}
+
+TEST (node, block_processor_queue_bound)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	// Nothing is drained once the processor is stopped
+	node1.block_processor.stop ();
+	rai::genesis genesis;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), rai::test_genesis_key.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	std::vector<std::shared_ptr<rai::block>> blocks (rai::block_processor::queue_max / 2, send1);
+	ASSERT_FALSE (node1.block_processor.saturated (rai::block_origin::bootstrap));
+	ASSERT_FALSE (node1.block_processor.add (blocks, rai::block_origin::bootstrap));
+	ASSERT_TRUE (node1.block_processor.saturated (rai::block_origin::bootstrap));
+	ASSERT_FALSE (node1.block_processor.saturated (rai::block_origin::live));
+	ASSERT_FALSE (node1.block_processor.add (blocks, rai::block_origin::bootstrap));
+	ASSERT_TRUE (node1.block_processor.add (send1, rai::block_origin::bootstrap));
+	ASSERT_EQ (1, node1.block_processor.dropped[static_cast<size_t> (rai::block_origin::bootstrap)]);
+	ASSERT_EQ (rai::block_processor::queue_max, node1.block_processor.queue_size (rai::block_origin::bootstrap));
+	std::vector<std::shared_ptr<rai::block>> dropped;
+	ASSERT_FALSE (node1.block_processor.add (std::vector<std::shared_ptr<rai::block>> (1, send1), rai::block_origin::unchecked, &dropped));
+	ASSERT_TRUE (dropped.empty ());
+	ASSERT_TRUE (node1.block_processor.add (std::vector<std::shared_ptr<rai::block>> (2, send1), rai::block_origin::bootstrap, &dropped));
+	ASSERT_EQ (2, dropped.size ());
+	ASSERT_FALSE (node1.block_processor.add (send1, rai::block_origin::live));
+	ASSERT_EQ (1, node1.block_processor.queue_size (rai::block_origin::live));
+}
+
+TEST (signature_checker, batches)
+{
+	rai::signature_checker checker (2);
+	rai::keypair key;
+	std::vector<rai::block_hash> hashes;
+	std::vector<rai::signature> signatures;
+	for (auto i (0); i < 1000; ++i)
+	{
+		hashes.push_back (i);
+		signatures.push_back (rai::sign_message (key.prv, key.pub, hashes.back ()));
+	}
+	signatures[500].bytes[0] ^= 0x1;
+	std::vector<unsigned char const *> messages;
+	std::vector<size_t> lengths;
+	std::vector<unsigned char const *> pub_keys;
+	std::vector<unsigned char const *> signature_pointers;
+	std::vector<int> verifications (hashes.size (), 0);
+	for (size_t i (0); i < hashes.size (); ++i)
+	{
+		messages.push_back (hashes[i].bytes.data ());
+		lengths.push_back (sizeof (rai::block_hash));
+		pub_keys.push_back (key.pub.bytes.data ());
+		signature_pointers.push_back (signatures[i].bytes.data ());
+	}
+	rai::signature_check_set check = { hashes.size (), messages.data (), lengths.data (), pub_keys.data (), signature_pointers.data (), verifications.data () };
+	checker.verify (check);
+	for (size_t i (0); i < verifications.size (); ++i)
+	{
+		ASSERT_EQ (i == 500 ? 0 : 1, verifications[i]);
+	}
+}
+
+TEST (vote_processor, queue)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::genesis genesis;
+	rai::keypair key1;
+	auto send1 (std::make_shared<rai::send_block> (genesis.hash (), key1.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	{
+		rai::transaction transaction (node1.store.environment, nullptr, true);
+		ASSERT_EQ (rai::process_result::progress, node1.ledger.process (transaction, *send1).code);
+		node1.active.start (transaction, send1);
+	}
+	auto votes1 (node1.active.roots.find (send1->root ())->election);
+	auto vote1 (std::make_shared<rai::vote> (rai::test_genesis_key.pub, rai::test_genesis_key.prv, 1, send1));
+	auto vote2 (std::make_shared<rai::vote> (key1.pub, key1.prv, 1, send1));
+	vote2->signature.bytes[0] ^= 1;
+	ASSERT_FALSE (node1.vote_processor.add (vote1, rai::endpoint ()));
+	ASSERT_FALSE (node1.vote_processor.add (vote2, rai::endpoint ()));
+	node1.vote_processor.flush ();
+	ASSERT_EQ (0, node1.vote_processor.size ());
+	ASSERT_EQ (0, node1.vote_processor.dropped);
+	ASSERT_NE (votes1->votes.rep_votes.end (), votes1->votes.rep_votes.find (rai::test_genesis_key.pub));
+	ASSERT_EQ (votes1->votes.rep_votes.end (), votes1->votes.rep_votes.find (key1.pub));
+}
+
+TEST (block_filter, apply)
+{
+	rai::block_filter filter (16);
+	rai::block_hash hash1 (0);
+	rai::block_hash hash2 (0);
+	hash1.qwords[0] = 1;
+	hash2.qwords[0] = 17;
+	ASSERT_FALSE (filter.apply (hash1));
+	ASSERT_TRUE (filter.apply (hash1));
+	ASSERT_EQ (1, filter.hits);
+	ASSERT_EQ (1, filter.misses);
+	// hash2 maps to the same slot and evicts hash1
+	ASSERT_FALSE (filter.apply (hash2));
+	ASSERT_FALSE (filter.apply (hash1));
+	ASSERT_EQ (3, filter.misses);
+}
+
+TEST (vote_signature_cache, reuse)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	rai::genesis genesis;
+	auto block1 (std::make_shared<rai::send_block> (genesis.hash (), rai::test_genesis_key.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	auto block2 (std::make_shared<rai::send_block> (genesis.hash (), rai::test_genesis_key.pub, rai::genesis_amount - 200, rai::test_genesis_key.prv, rai::test_genesis_key.pub, 0));
+	auto & prv (rai::test_genesis_key.prv);
+	rai::transaction transaction (node.store.environment, nullptr, false);
+	auto vote1 (node.vote_signatures.generate (transaction, rai::test_genesis_key.pub, prv, block1));
+	auto vote2 (node.vote_signatures.generate (transaction, rai::test_genesis_key.pub, prv, block1));
+	ASSERT_EQ (vote1.first, vote2.first);
+	ASSERT_EQ (vote1.second, vote2.second);
+	ASSERT_EQ (1, node.vote_signatures.hits);
+	ASSERT_EQ (1, node.vote_signatures.misses);
+	// A vote for another block raises the sequence number so the cached vote can't be replayed
+	node.vote_signatures.generate (transaction, rai::test_genesis_key.pub, prv, block2);
+	auto vote3 (node.vote_signatures.generate (transaction, rai::test_genesis_key.pub, prv, block1));
+	ASSERT_NE (vote1.first, vote3.first);
+	ASSERT_GT (vote3.first->sequence, vote1.first->sequence);
+	ASSERT_EQ (1, node.vote_signatures.hits);
+	ASSERT_EQ (3, node.vote_signatures.misses);
+}
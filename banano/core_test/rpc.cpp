@@ -1382,6 +1382,8 @@ TEST (rpc_config, serialization)
 	config1.enable_control = true;
 	config1.frontier_request_limit = 8192;
 	config1.chain_request_limit = 4096;
+	config1.executor_threads = 3;
+	config1.scan_concurrency = 1;
 	boost::property_tree::ptree tree;
 	config1.serialize_json (tree);
 	rai::rpc_config config2;
@@ -1390,12 +1392,74 @@ TEST (rpc_config, serialization)
 	ASSERT_NE (config2.enable_control, config1.enable_control);
 	ASSERT_NE (config2.frontier_request_limit, config1.frontier_request_limit);
 	ASSERT_NE (config2.chain_request_limit, config1.chain_request_limit);
+	ASSERT_NE (config2.executor_threads, config1.executor_threads);
+	ASSERT_NE (config2.scan_concurrency, config1.scan_concurrency);
 	config2.deserialize_json (tree);
 	ASSERT_EQ (config2.address, config1.address);
 	ASSERT_EQ (config2.port, config1.port);
 	ASSERT_EQ (config2.enable_control, config1.enable_control);
 	ASSERT_EQ (config2.frontier_request_limit, config1.frontier_request_limit);
 	ASSERT_EQ (config2.chain_request_limit, config1.chain_request_limit);
+	ASSERT_EQ (config2.executor_threads, config1.executor_threads);
+	ASSERT_EQ (config2.scan_concurrency, config1.scan_concurrency);
+	// No thread would be left for point requests
+	tree.put ("executor_threads", 1);
+	ASSERT_TRUE (config2.deserialize_json (tree));
+}
+
+// A running scan holds back the next scan but not point requests
+TEST (rpc_executor, scan_limit)
+{
+	rai::rpc_executor executor (2, 2);
+	std::promise<void> release;
+	auto released (release.get_future ().share ());
+	std::atomic<unsigned> scans (0);
+	std::promise<void> started;
+	executor.add (rai::rpc_request_class::scan, [&scans, &started, released]() {
+		++scans;
+		started.set_value ();
+		released.wait ();
+	});
+	started.get_future ().wait ();
+	executor.add (rai::rpc_request_class::scan, [&scans]() {
+		++scans;
+	});
+	std::promise<void> point;
+	executor.add (rai::rpc_request_class::point, [&point]() {
+		point.set_value ();
+	});
+	ASSERT_EQ (std::future_status::ready, point.get_future ().wait_for (std::chrono::seconds (5)));
+	ASSERT_EQ (1, scans);
+	ASSERT_EQ (1, executor.stats (rai::rpc_request_class::scan).queued);
+	release.set_value ();
+	auto iterations (0);
+	while (scans < 2)
+	{
+		std::this_thread::sleep_for (std::chrono::milliseconds (10));
+		++iterations;
+		ASSERT_LT (iterations, 500);
+	}
+	ASSERT_EQ (1, executor.stats (rai::rpc_request_class::point).requests);
+}
+
+// A single thread configuration still runs point requests while a scan is blocked
+TEST (rpc_executor, single_thread)
+{
+	rai::rpc_executor executor (1, 1);
+	std::promise<void> release;
+	auto released (release.get_future ().share ());
+	std::promise<void> started;
+	executor.add (rai::rpc_request_class::scan, [&started, released]() {
+		started.set_value ();
+		released.wait ();
+	});
+	started.get_future ().wait ();
+	std::promise<void> point;
+	executor.add (rai::rpc_request_class::point, [&point]() {
+		point.set_value ();
+	});
+	ASSERT_EQ (std::future_status::ready, point.get_future ().wait_for (std::chrono::seconds (5)));
+	release.set_value ();
 }
 
 TEST (rpc, search_pending)
@@ -1445,7 +1509,7 @@ TEST (rpc, version)
 	ASSERT_EQ (200, response1.status);
 	ASSERT_EQ ("1", response1.json.get<std::string> ("rpc_version"));
 	ASSERT_EQ (200, response1.status);
-	ASSERT_EQ ("10", response1.json.get<std::string> ("store_version"));
+	ASSERT_EQ ("12", response1.json.get<std::string> ("store_version"));
 	ASSERT_EQ (boost::str (boost::format ("Banano %1%.%2%") % BANANO_VERSION_MAJOR % BANANO_VERSION_MINOR), response1.json.get<std::string> ("node_vendor"));
 	auto headers (response1.resp.base ());
 	auto allowed_origin (headers.at ("Access-Control-Allow-Origin"));
@@ -1521,8 +1585,8 @@ TEST (rpc, work_peer_bad)
 	node2.config.work_peers.push_back (std::make_pair (boost::asio::ip::address_v6::any (), 0));
 	rai::block_hash hash1 (1);
 	std::atomic<uint64_t> work (0);
-	node2.generate_work (hash1, [&work](uint64_t work_a) {
-		work = work_a;
+	node2.generate_work (hash1, [&work](boost::optional<uint64_t> const & work_a) {
+		work = *work_a;
 	});
 	while (rai::work_validate (hash1, work))
 	{
@@ -1544,8 +1608,8 @@ TEST (rpc, work_peer_one)
 	node2.config.work_peers.push_back (std::make_pair (node1.network.endpoint ().address (), rpc.config.port));
 	rai::keypair key1;
 	uint64_t work (0);
-	node2.generate_work (key1.pub, [&work](uint64_t work_a) {
-		work = work_a;
+	node2.generate_work (key1.pub, [&work](boost::optional<uint64_t> const & work_a) {
+		work = *work_a;
 	});
 	while (rai::work_validate (key1.pub, work))
 	{
@@ -1584,8 +1648,8 @@ TEST (rpc, work_peer_many)
 	{
 		rai::keypair key1;
 		uint64_t work (0);
-		node1.generate_work (key1.pub, [&work](uint64_t work_a) {
-			work = work_a;
+		node1.generate_work (key1.pub, [&work](boost::optional<uint64_t> const & work_a) {
+			work = *work_a;
 		});
 		while (rai::work_validate (key1.pub, work))
 		{
@@ -2051,6 +2115,35 @@ TEST (rpc, bootstrap_any)
 	ASSERT_TRUE (success.empty ());
 }
 
+TEST (rpc, bootstrap_peers)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::endpoint peer (boost::asio::ip::address_v6::loopback (), 24001);
+	node1.bootstrap_initiator.peer_scores.pull_finished (peer, 100, 2.0, false);
+	node1.bootstrap_initiator.peer_scores.pull_finished (peer, 0, 1.0, true);
+	rai::rpc rpc (system.service, node1, rai::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "bootstrap_peers");
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	auto & peers_node (response.json.get_child ("peers"));
+	ASSERT_EQ (1, peers_node.size ());
+	std::stringstream text;
+	text << peer;
+	auto & entry (peers_node.get_child (boost::property_tree::ptree::path_type (text.str (), '\0')));
+	ASSERT_EQ ("100", entry.get<std::string> ("blocks"));
+	ASSERT_EQ ("2", entry.get<std::string> ("pulls"));
+	ASSERT_EQ ("1", entry.get<std::string> ("failures"));
+	// The second pull moved the rate a quarter of the way from 50 to 0
+	ASSERT_EQ (37.5, std::stod (entry.get<std::string> ("rate")));
+}
+
 TEST (rpc, republish)
 {
 	rai::system system (24000, 2);
@@ -2724,6 +2817,47 @@ TEST (rpc, delegators)
 	ASSERT_EQ ("340282366920938463463374607431768211355", delegators.get<std::string> (key.pub.to_account ()));
 }
 
+TEST (rpc, delegators_paging)
+{
+	rai::system system (24000, 1);
+	rai::keypair key;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	system.wallet (0)->insert_adhoc (key.prv);
+	auto & node1 (*system.nodes[0]);
+	auto latest (system.nodes[0]->latest (rai::test_genesis_key.pub));
+	rai::send_block send (latest, key.pub, 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, node1.generate_work (latest));
+	system.nodes[0]->process (send);
+	rai::open_block open (send.hash (), rai::test_genesis_key.pub, key.pub, key.prv, key.pub, node1.generate_work (key.pub));
+	ASSERT_EQ (rai::process_result::progress, system.nodes[0]->process (open).code);
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	auto first (std::min (rai::test_genesis_key.pub, key.pub));
+	auto second (std::max (rai::test_genesis_key.pub, key.pub));
+	boost::property_tree::ptree request;
+	request.put ("action", "delegators");
+	request.put ("account", rai::test_genesis_key.pub.to_account ());
+	request.put ("count", "1");
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	auto & delegators_node (response.json.get_child ("delegators"));
+	ASSERT_EQ (1, delegators_node.size ());
+	ASSERT_EQ (first.to_account (), delegators_node.begin ()->first);
+	request.put ("start", second.to_account ());
+	test_response response2 (request, rpc, system.service);
+	while (response2.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response2.status);
+	auto & delegators_node2 (response2.json.get_child ("delegators"));
+	ASSERT_EQ (1, delegators_node2.size ());
+	ASSERT_EQ (second.to_account (), delegators_node2.begin ()->first);
+}
+
 TEST (rpc, delegators_count)
 {
 	rai::system system (24000, 1);
@@ -3049,6 +3183,21 @@ TEST (rpc, accounts_create)
 	ASSERT_EQ (8, accounts.size ());
 }
 
+// Handlers stop waiting on work once the RPC is stopping, so the executor's threads can be joined
+TEST (rpc, generate_work_stopped)
+{
+	rai::system system (24000, 1);
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	rai::block_hash root (1);
+	auto work (rpc.generate_work (root));
+	ASSERT_TRUE (!!work);
+	ASSERT_FALSE (rai::work_validate (root, *work));
+	ASSERT_TRUE (rpc.work_pending.empty ());
+	rpc.stop ();
+	ASSERT_FALSE (!!rpc.generate_work (root));
+}
+
 TEST (rpc, block_create)
 {
 	rai::system system (24000, 1);
@@ -3517,3 +3666,189 @@ TEST (rpc, confirmation_history)
 	ASSERT_EQ ((rai::genesis_amount - rai::kBAN_ratio).convert_to<std::string> (), tally);
 	system.stop ();
 }
+
+TEST (rpc, confirmation_latency)
+{
+	rai::system system (24000, 1);
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	system.wallet (0)->send_action (rai::test_genesis_key.pub, rai::test_genesis_key.pub, rai::kBAN_ratio);
+	auto iterations (0);
+	while (system.nodes[0]->active.latency_percentiles ({ 1.0 }).empty ())
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "confirmation_latency");
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	ASSERT_LE (1, std::stoul (response.json.get<std::string> ("count")));
+	auto p50 (std::stoul (response.json.get<std::string> ("p50")));
+	auto max (std::stoul (response.json.get<std::string> ("max")));
+	ASSERT_LE (p50, max);
+	system.stop ();
+}
+
+TEST (rpc, json_writer)
+{
+	boost::property_tree::ptree tree;
+	boost::property_tree::ptree blocks;
+	boost::property_tree::ptree hashes;
+	boost::property_tree::ptree entry;
+	entry.put ("", "a/\"\\\t\x01");
+	hashes.push_back (std::make_pair ("", entry));
+	hashes.push_back (std::make_pair ("", entry));
+	blocks.add_child ("account1", hashes);
+	blocks.add_child ("account2", boost::property_tree::ptree ());
+	boost::property_tree::ptree source;
+	source.put ("amount", "1");
+	source.put ("source", "account3");
+	boost::property_tree::ptree amounts;
+	amounts.add_child ("hash1", source);
+	amounts.put ("hash2", "2");
+	blocks.add_child ("account3", amounts);
+	tree.add_child ("blocks", blocks);
+	std::stringstream ostream;
+	boost::property_tree::write_json (ostream, tree);
+	std::string body;
+	rai::json_writer writer (body);
+	writer.begin_object ();
+	writer.begin_object ("blocks");
+	writer.begin_array ("account1");
+	writer.push_back ("a/\"\\\t\x01");
+	writer.push_back ("a/\"\\\t\x01");
+	writer.end ();
+	writer.begin_object ("account2");
+	writer.end ();
+	writer.begin_object ("account3");
+	writer.begin_object ("hash1");
+	writer.put ("amount", "1");
+	writer.put ("source", "account3");
+	writer.end ();
+	writer.put ("hash2", "2");
+	writer.end ();
+	writer.end ();
+	writer.end ();
+	ASSERT_EQ (ostream.str (), body);
+	std::stringstream ostream_empty;
+	boost::property_tree::write_json (ostream_empty, boost::property_tree::ptree ());
+	std::string body_empty;
+	rai::json_writer writer_empty (body_empty);
+	writer_empty.begin_object ();
+	writer_empty.end ();
+	ASSERT_EQ (ostream_empty.str (), body_empty);
+}
+
+TEST (rpc, persistent_connection)
+{
+	rai::system system (24000, 1);
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	boost::asio::ip::tcp::socket sock (system.service);
+	boost::beast::flat_buffer buffer;
+	boost::beast::http::request<boost::beast::http::string_body> req;
+	req.method (boost::beast::http::verb::post);
+	req.target ("/");
+	req.version (11);
+	req.body () = "{\"action\": \"block_count\"}";
+	req.prepare_payload ();
+	boost::beast::http::response<boost::beast::http::string_body> resp1;
+	boost::beast::http::response<boost::beast::http::string_body> resp2;
+	auto done (0);
+	// Both requests are written before either response is read
+	sock.async_connect (rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), rpc.config.port), [&](boost::system::error_code const & ec) {
+		ASSERT_FALSE (ec);
+		boost::beast::http::async_write (sock, req, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+			ASSERT_FALSE (ec);
+			boost::beast::http::async_write (sock, req, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+				ASSERT_FALSE (ec);
+				boost::beast::http::async_read (sock, buffer, resp1, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+					ASSERT_FALSE (ec);
+					boost::beast::http::async_read (sock, buffer, resp2, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+						ASSERT_FALSE (ec);
+						done = 1;
+					});
+				});
+			});
+		});
+	});
+	auto iterations (0);
+	while (done == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	ASSERT_EQ (boost::beast::http::status::ok, resp1.result ());
+	ASSERT_TRUE (resp1.keep_alive ());
+	ASSERT_EQ (boost::beast::http::status::ok, resp2.result ());
+	ASSERT_EQ (1, rpc.connections.load ());
+	ASSERT_EQ (2, rpc.requests.load ());
+	rpc.stop ();
+	system.stop ();
+}
+
+// A handler answering twice must not write a second response or start a second read on a kept alive connection
+TEST (rpc, persistent_connection_double_response)
+{
+	rai::system system (24000, 1);
+	rai::rpc rpc (system.service, *system.nodes[0], rai::rpc_config (true));
+	rpc.start ();
+	boost::asio::ip::tcp::socket sock (system.service);
+	boost::beast::flat_buffer buffer;
+	boost::beast::http::request<boost::beast::http::string_body> req1;
+	req1.method (boost::beast::http::verb::post);
+	req1.target ("/");
+	req1.version (11);
+	// pending answers with an error for the count and then with the pending list
+	req1.body () = "{\"action\": \"pending\", \"account\": \"" + rai::test_genesis_key.pub.to_account () + "\", \"count\": \"invalid\"}";
+	req1.prepare_payload ();
+	boost::beast::http::request<boost::beast::http::string_body> req2 (req1);
+	req2.body () = "{\"action\": \"block_count\"}";
+	req2.prepare_payload ();
+	boost::beast::http::response<boost::beast::http::string_body> resp1;
+	boost::beast::http::response<boost::beast::http::string_body> resp2;
+	auto done (0);
+	sock.async_connect (rai::tcp_endpoint (boost::asio::ip::address_v6::loopback (), rpc.config.port), [&](boost::system::error_code const & ec) {
+		ASSERT_FALSE (ec);
+		boost::beast::http::async_write (sock, req1, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+			ASSERT_FALSE (ec);
+			boost::beast::http::async_read (sock, buffer, resp1, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+				ASSERT_FALSE (ec);
+				boost::beast::http::async_write (sock, req2, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+					ASSERT_FALSE (ec);
+					boost::beast::http::async_read (sock, buffer, resp2, [&](boost::system::error_code const & ec, size_t bytes_transferred) {
+						ASSERT_FALSE (ec);
+						done = 1;
+					});
+				});
+			});
+		});
+	});
+	auto iterations (0);
+	while (done == 0)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+	}
+	boost::property_tree::ptree json1;
+	std::stringstream body1 (resp1.body ());
+	boost::property_tree::read_json (body1, json1);
+	ASSERT_EQ ("Invalid count limit", json1.get<std::string> ("error"));
+	boost::property_tree::ptree json2;
+	std::stringstream body2 (resp2.body ());
+	boost::property_tree::read_json (body2, json2);
+	ASSERT_EQ ("1", json2.get<std::string> ("count"));
+	ASSERT_EQ (1, rpc.connections.load ());
+	ASSERT_EQ (2, rpc.requests.load ());
+	rpc.stop ();
+	system.stop ();
+}
@@ -667,6 +667,54 @@ TEST (wallet, work_generate)
 	}
 }
 
+// Work for the next block is cached when a wallet account's block arrives from elsewhere
+TEST (wallet, work_precache)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	auto wallet (system.wallet (0));
+	wallet->insert_adhoc (rai::test_genesis_key.prv, false);
+	rai::keypair key;
+	rai::genesis genesis;
+	auto send (std::make_shared<rai::send_block> (genesis.hash (), key.pub, rai::genesis_amount - 100, rai::test_genesis_key.prv, rai::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	node1.process_active (send);
+	auto iterations (0);
+	auto again (true);
+	while (again)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		uint64_t work (0);
+		again = wallet->store.work_get (transaction, rai::test_genesis_key.pub, work) || rai::work_validate (send->hash (), work);
+	}
+}
+
+// Moving to a newer root cancels work on the old one, which still leaves the active set
+TEST (wallet, work_precache_superseded)
+{
+	rai::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	rai::keypair key;
+	system.wallet (0)->insert_adhoc (key.prv, false);
+	// The root of an account which isn't open yet is the account itself
+	node1.wallets.work_precache (key.pub, 1);
+	node1.wallets.work_precache (key.pub, key.pub);
+	auto iterations (0);
+	auto again (true);
+	while (again)
+	{
+		system.poll ();
+		++iterations;
+		ASSERT_LT (iterations, 200);
+		rai::transaction transaction (node1.store.environment, nullptr, false);
+		uint64_t work (0);
+		std::lock_guard<std::mutex> lock (node1.wallets.precache_mutex);
+		again = !node1.wallets.precache_active.empty () || system.wallet (0)->store.work_get (transaction, key.pub, work) || rai::work_validate (key.pub, work);
+	}
+}
+
 TEST (wallet, unsynced_work)
 {
 	rai::system system (24000, 1);
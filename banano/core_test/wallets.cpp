@@ -76,7 +76,7 @@ TEST (wallets, wallet_create_max)
 	rai::system system (24000, 1);
 	bool error (false);
 	rai::wallets wallets (error, *system.nodes[0]);
-	const int nonWalletDbs = 17;
+	const int nonWalletDbs = 14;
 	for (int i = 0; i < system.nodes[0]->config.lmdb_max_dbs - nonWalletDbs; i++)
 	{
 		rai::keypair key;
@@ -93,3 +93,55 @@ TEST (wallets, wallet_create_max)
 	auto existing = wallets.items.find (key.pub);
 	ASSERT_TRUE (existing == wallets.items.end ());
 }
+
+TEST (wallets, representatives)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	{
+		std::lock_guard<std::mutex> lock (node.wallets.representatives_mutex);
+		ASSERT_TRUE (node.wallets.representatives.empty ());
+	}
+	rai::keypair key;
+	system.wallet (0)->insert_adhoc (key.prv);
+	{
+		std::lock_guard<std::mutex> lock (node.wallets.representatives_mutex);
+		ASSERT_TRUE (node.wallets.representatives.empty ());
+	}
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	{
+		std::lock_guard<std::mutex> lock (node.wallets.representatives_mutex);
+		ASSERT_EQ (1, node.wallets.representatives.size ());
+		ASSERT_NE (node.wallets.representatives.end (), node.wallets.representatives.find (rai::test_genesis_key.pub));
+	}
+	node.wallets.compute_reps ();
+	{
+		std::lock_guard<std::mutex> lock (node.wallets.representatives_mutex);
+		ASSERT_EQ (1, node.wallets.representatives.size ());
+	}
+}
+
+TEST (wallets, representatives_update)
+{
+	rai::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	rai::keypair key;
+	system.wallet (0)->insert_adhoc (rai::test_genesis_key.prv);
+	system.wallet (0)->insert_adhoc (key.prv);
+	ASSERT_FALSE (system.wallet (0)->change_sync (rai::test_genesis_key.pub, key.pub));
+	{
+		// Weight moved off genesis so only the new representative remains
+		std::lock_guard<std::mutex> lock (node.wallets.representatives_mutex);
+		ASSERT_EQ (1, node.wallets.representatives.size ());
+		ASSERT_NE (node.wallets.representatives.end (), node.wallets.representatives.find (key.pub));
+	}
+	{
+		rai::transaction transaction (node.store.environment, nullptr, true);
+		system.wallet (0)->store.erase (transaction, key.pub);
+		node.wallets.representative_check (transaction, key.pub);
+	}
+	{
+		std::lock_guard<std::mutex> lock (node.wallets.representatives_mutex);
+		ASSERT_TRUE (node.wallets.representatives.empty ());
+	}
+}
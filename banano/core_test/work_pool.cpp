@@ -20,6 +20,31 @@ TEST (work, validate)
 	ASSERT_FALSE (rai::work_validate (send_block));
 }
 
+TEST (work, kernels)
+{
+	rai::uint256_union root;
+	rai::random_pool.GenerateBlock (root.bytes.data (), root.bytes.size ());
+	rai::work_root work_root;
+	rai::work_root_init (work_root, root.bytes.data ());
+	auto kernels (rai::work_kernels ());
+	ASSERT_FALSE (kernels.empty ());
+	for (auto & kernel : kernels)
+	{
+		ASSERT_LE (kernel.lanes, 8);
+		std::array<uint64_t, 8> nonces;
+		std::array<uint64_t, 8> values;
+		for (auto i (0); i < 64; ++i)
+		{
+			rai::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (nonces.data ()), sizeof (nonces));
+			kernel.values (work_root, nonces.data (), values.data ());
+			for (size_t j (0); j < kernel.lanes; ++j)
+			{
+				ASSERT_EQ (rai::work_value (root, nonces[j]), values[j]) << kernel.name;
+			}
+		}
+	}
+}
+
 TEST (work, cancel)
 {
 	rai::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
@@ -50,6 +75,40 @@ TEST (work, cancel_many)
 	pool.cancel (key1);
 }
 
+TEST (work, shared_root)
+{
+	rai::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	rai::uint256_union root (1);
+	std::promise<boost::optional<uint64_t>> work1;
+	std::promise<boost::optional<uint64_t>> work2;
+	pool.generate (root, [&work1](boost::optional<uint64_t> const & work_a) {
+		work1.set_value (work_a);
+	},
+	rai::work_priority::precache);
+	pool.generate (root, [&work2](boost::optional<uint64_t> const & work_a) {
+		work2.set_value (work_a);
+	},
+	rai::work_priority::wallet);
+	ASSERT_GE (1, pool.size ());
+	auto result1 (work1.get_future ().get ());
+	auto result2 (work2.get_future ().get ());
+	ASSERT_TRUE (!!result1);
+	ASSERT_EQ (result1, result2);
+	ASSERT_FALSE (rai::work_validate (root, *result1));
+}
+
+TEST (work, deadline)
+{
+	rai::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	rai::uint256_union root (1);
+	std::promise<boost::optional<uint64_t>> work;
+	pool.generate (root, [&work](boost::optional<uint64_t> const & work_a) {
+		work.set_value (work_a);
+	},
+	rai::work_priority::precache, std::chrono::steady_clock::now () - std::chrono::seconds (1));
+	ASSERT_FALSE (!!work.get_future ().get ());
+}
+
 TEST (work, DISABLED_opencl)
 {
 	rai::logging logging;
@@ -85,8 +85,8 @@ public:
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
 		ledger.store.representation_add (transaction, representative, balance);
 		ledger.store.representation_add (transaction, hash, 0 - balance);
-		ledger.store.block_del (transaction, hash);
 		ledger.change_latest (transaction, account, block_a.hashables.previous, representative, info.balance, info.block_count - 1);
+		ledger.store.block_del (transaction, hash);
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
@@ -160,7 +160,7 @@ public:
 class ledger_processor : public rai::block_visitor
 {
 public:
-	ledger_processor (rai::ledger &, MDB_txn *);
+	ledger_processor (rai::ledger &, MDB_txn *, rai::signature_verification = rai::signature_verification::unknown);
 	virtual ~ledger_processor () = default;
 	void send_block (rai::send_block const &) override;
 	void receive_block (rai::receive_block const &) override;
@@ -170,6 +170,7 @@ public:
 	void state_block_impl (rai::state_block const &);
 	rai::ledger & ledger;
 	MDB_txn * transaction;
+	rai::signature_verification verification;
 	rai::process_return result;
 };
 
@@ -189,7 +190,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 	result.code = existing ? rai::process_result::old : rai::process_result::progress; // Have we seen this block before? (Unambiguous)
 	if (result.code == rai::process_result::progress)
 	{
-		result.code = validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Unambiguous)
+		result.code = verification != rai::signature_verification::valid && validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Unambiguous)
 		if (result.code == rai::process_result::progress)
 		{
 			result.code = block_a.hashables.account.is_zero () ? rai::process_result::opened_burn_account : rai::process_result::progress; // Is this for the burn account? (Unambiguous)
@@ -251,7 +252,7 @@ void ledger_processor::state_block_impl (rai::state_block const & block_a)
 				if (result.code == rai::process_result::progress)
 				{
 					result.state_is_send = is_send;
-					ledger.store.block_put (transaction, hash, block_a);
+					ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (0, block_a.hashables.account, info.block_count + 1, block_a.hashables.balance));
 
 					if (!info.rep_block.is_zero ())
 					{
@@ -310,7 +311,7 @@ void ledger_processor::change_block (rai::change_block const & block_a)
 					result.code = validate_message (account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is this block signed correctly (Malformed)
 					if (result.code == rai::process_result::progress)
 					{
-						ledger.store.block_put (transaction, hash, block_a);
+						ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (0, account, info.block_count + 1, info.balance));
 						auto balance (ledger.balance (transaction, block_a.hashables.previous));
 						ledger.store.representation_add (transaction, hash, balance);
 						ledger.store.representation_add (transaction, info.rep_block, 0 - balance);
@@ -356,7 +357,7 @@ void ledger_processor::send_block (rai::send_block const & block_a)
 						{
 							auto amount (info.balance.number () - block_a.hashables.balance.number ());
 							ledger.store.representation_add (transaction, info.rep_block, 0 - amount);
-							ledger.store.block_put (transaction, hash, block_a);
+							ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (0, account, info.block_count + 1, block_a.hashables.balance));
 							ledger.change_latest (transaction, account, hash, info.rep_block, block_a.hashables.balance, info.block_count + 1);
 							ledger.store.pending_put (transaction, rai::pending_key (block_a.hashables.destination, hash), { account, amount });
 							ledger.store.frontier_del (transaction, block_a.hashables.previous);
@@ -411,7 +412,7 @@ void ledger_processor::receive_block (rai::receive_block const & block_a)
 									auto error (ledger.store.account_get (transaction, pending.source, source_info));
 									assert (!error);
 									ledger.store.pending_del (transaction, key);
-									ledger.store.block_put (transaction, hash, block_a);
+									ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (0, account, info.block_count + 1, new_balance));
 									ledger.change_latest (transaction, account, hash, info.rep_block, new_balance, info.block_count + 1);
 									ledger.store.representation_add (transaction, info.rep_block, pending.amount.number ());
 									ledger.store.frontier_del (transaction, block_a.hashables.previous);
@@ -443,7 +444,7 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 		result.code = source_missing ? rai::process_result::gap_source : rai::process_result::progress; // Have we seen the source block? (Harmless)
 		if (result.code == rai::process_result::progress)
 		{
-			result.code = rai::validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
+			result.code = verification != rai::signature_verification::valid && rai::validate_message (block_a.hashables.account, hash, block_a.signature) ? rai::process_result::bad_signature : rai::process_result::progress; // Is the signature valid (Malformed)
 			if (result.code == rai::process_result::progress)
 			{
 				rai::account_info info;
@@ -462,7 +463,7 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 							auto error (ledger.store.account_get (transaction, pending.source, source_info));
 							assert (!error);
 							ledger.store.pending_del (transaction, key);
-							ledger.store.block_put (transaction, hash, block_a);
+							ledger.store.block_put (transaction, hash, block_a, rai::block_sideband (0, block_a.hashables.account, info.block_count + 1, pending.amount));
 							ledger.change_latest (transaction, block_a.hashables.account, hash, hash, pending.amount.number (), info.block_count + 1);
 							ledger.store.representation_add (transaction, hash, pending.amount.number ());
 							ledger.store.frontier_put (transaction, hash, block_a.hashables.account);
@@ -476,9 +477,10 @@ void ledger_processor::open_block (rai::open_block const & block_a)
 	}
 }
 
-ledger_processor::ledger_processor (rai::ledger & ledger_a, MDB_txn * transaction_a) :
+ledger_processor::ledger_processor (rai::ledger & ledger_a, MDB_txn * transaction_a, rai::signature_verification verification_a) :
 ledger (ledger_a),
-transaction (transaction_a)
+transaction (transaction_a),
+verification (verification_a)
 {
 }
 } // namespace
@@ -570,9 +572,9 @@ rai::uint128_t rai::ledger::account_pending (MDB_txn * transaction_a, rai::accou
 	return result;
 }
 
-rai::process_return rai::ledger::process (MDB_txn * transaction_a, rai::block const & block_a)
+rai::process_return rai::ledger::process (MDB_txn * transaction_a, rai::block const & block_a, rai::signature_verification verification_a)
 {
-	ledger_processor processor (*this, transaction_a);
+	ledger_processor processor (*this, transaction_a, verification_a);
 	block_a.visit (processor);
 	return processor.result;
 }
@@ -710,31 +712,40 @@ void rai::ledger::rollback (MDB_txn * transaction_a, rai::block_hash const & blo
 rai::account rai::ledger::account (MDB_txn * transaction_a, rai::block_hash const & hash_a)
 {
 	rai::account result;
-	auto hash (hash_a);
-	rai::block_hash successor (1);
-	rai::block_info block_info;
-	std::unique_ptr<rai::block> block (store.block_get (transaction_a, hash));
-	while (!successor.is_zero () && block->type () != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
-	{
-		successor = store.block_successor (transaction_a, hash);
-		if (!successor.is_zero ())
-		{
-			hash = successor;
-			block = store.block_get (transaction_a, hash);
-		}
-	}
-	if (block->type () == rai::block_type::state)
+	rai::block_sideband sideband;
+	std::unique_ptr<rai::block> block (store.block_get (transaction_a, hash_a, &sideband));
+	if (!sideband.account.is_zero ())
 	{
-		auto state_block (dynamic_cast<rai::state_block *> (block.get ()));
-		result = state_block->hashables.account;
-	}
-	else if (successor.is_zero ())
-	{
-		result = store.frontier_get (transaction_a, hash);
+		result = sideband.account;
 	}
 	else
 	{
-		result = block_info.account;
+		// Blocks stored before the sideband was populated, search the chain
+		auto hash (hash_a);
+		rai::block_hash successor (1);
+		rai::block_info block_info;
+		while (!successor.is_zero () && block->type () != rai::block_type::state && store.block_info_get (transaction_a, successor, block_info))
+		{
+			successor = store.block_successor (transaction_a, hash);
+			if (!successor.is_zero ())
+			{
+				hash = successor;
+				block = store.block_get (transaction_a, hash);
+			}
+		}
+		if (block->type () == rai::block_type::state)
+		{
+			auto state_block (dynamic_cast<rai::state_block *> (block.get ()));
+			result = state_block->hashables.account;
+		}
+		else if (successor.is_zero ())
+		{
+			result = store.frontier_get (transaction_a, hash);
+		}
+		else
+		{
+			result = block_info.account;
+		}
 	}
 	assert (!result.is_zero ());
 	return result;
@@ -820,6 +831,9 @@ void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & a
 	if (exists)
 	{
 		checksum_update (transaction_a, info.head);
+		auto rep_block (store.block_get (transaction_a, info.rep_block));
+		assert (rep_block != nullptr);
+		store.delegator_del (transaction_a, rep_block->representative (), account_a);
 	}
 	else
 	{
@@ -834,6 +848,9 @@ void rai::ledger::change_latest (MDB_txn * transaction_a, rai::account const & a
 		info.modified = rai::seconds_since_epoch ();
 		info.block_count = block_count_a;
 		store.account_put (transaction_a, account_a, info);
+		auto rep_block (store.block_get (transaction_a, rep_block_a));
+		assert (rep_block != nullptr);
+		store.delegator_put (transaction_a, rep_block->representative (), account_a, balance_a);
 		if (!(block_count_a % store.block_info_max) && !is_state)
 		{
 			rai::block_info block_info;
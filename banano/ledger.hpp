@@ -39,7 +39,7 @@ public:
 	rai::block_hash block_destination (MDB_txn *, rai::block const &);
 	rai::block_hash block_source (MDB_txn *, rai::block const &);
 	rai::uint128_t supply (MDB_txn *);
-	rai::process_return process (MDB_txn *, rai::block const &);
+	rai::process_return process (MDB_txn *, rai::block const &, rai::signature_verification = rai::signature_verification::unknown);
 	void rollback (MDB_txn *, rai::block_hash const &);
 	void change_latest (MDB_txn *, rai::account const &, rai::block_hash const &, rai::account const &, rai::uint128_union const &, uint64_t, bool = false);
 	void checksum_update (MDB_txn *, rai::block_hash const &);
@@ -58,6 +58,22 @@ rai::block_hash rai::block::hash () const
 	return result;
 }
 
+rai::block_hash rai::block::full_hash () const
+{
+	rai::uint256_union result;
+	blake2b_state hash_l;
+	auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
+	assert (status == 0);
+	hash (hash_l);
+	auto signature (block_signature ());
+	blake2b_update (&hash_l, signature.bytes.data (), sizeof (signature.bytes));
+	auto work (block_work ());
+	blake2b_update (&hash_l, &work, sizeof (work));
+	status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
+	assert (status == 0);
+	return result;
+}
+
 void rai::send_block::visit (rai::block_visitor & visitor_a) const
 {
 	visitor_a.send_block (*this);
@@ -44,6 +44,8 @@ class block
 public:
 	// Return a digest of the hashables in this block.
 	rai::block_hash hash () const;
+	// Return a digest of the hashables, signature and work, differs between copies of a block that were tampered with
+	rai::block_hash full_hash () const;
 	std::string to_json ();
 	virtual void hash (blake2b_state &) const = 0;
 	virtual uint64_t block_work () const = 0;
@@ -459,6 +459,13 @@ bool rai::validate_message (rai::public_key const & public_key, rai::uint256_uni
 	return result;
 }
 
+// Returns true if any signature in the batch is invalid, valid_a[i] is set to 1 for each valid signature
+bool rai::validate_message_batch (unsigned char const ** m, size_t * mlen, unsigned char const ** pk, unsigned char const ** RS, size_t num, int * valid_a)
+{
+	auto result (0 != ed25519_sign_open_batch (m, mlen, pk, RS, num, valid_a));
+	return result;
+}
+
 rai::uint128_union::uint128_union (std::string const & string_a)
 {
 	decode_hex (string_a);
@@ -124,6 +124,7 @@ using signature = uint512_union;
 
 rai::uint512_union sign_message (rai::raw_key const &, rai::public_key const &, rai::uint256_union const &);
 bool validate_message (rai::public_key const &, rai::uint256_union const &, rai::uint512_union const &);
+bool validate_message_batch (unsigned char const **, size_t *, unsigned char const **, unsigned char const **, size_t, int *);
 void deterministic_key (rai::uint256_union const &, uint32_t, rai::uint256_union &);
 }
 
@@ -15,6 +15,115 @@ bool rai::work_validate (rai::block const & block_a)
 	return work_validate (block_a.root (), block_a.block_work ());
 }
 
+namespace
+{
+class scalar_lanes
+{
+public:
+	using vec = uint64_t;
+	static size_t constexpr count = 1;
+	static vec load (uint64_t const * data_a)
+	{
+		return *data_a;
+	}
+	static void store (uint64_t * data_a, vec value_a)
+	{
+		*data_a = value_a;
+	}
+	static vec set1 (uint64_t value_a)
+	{
+		return value_a;
+	}
+	static vec add (vec a, vec b)
+	{
+		return a + b;
+	}
+	static vec bxor (vec a, vec b)
+	{
+		return a ^ b;
+	}
+	template <int N>
+	static vec rotr (vec a)
+	{
+		return (a >> N) | (a << (64 - N));
+	}
+};
+
+void values_scalar (rai::work_root const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	rai::work_blake2b::values<scalar_lanes> (root_a, nonces_a, values_a);
+}
+
+bool cpu_supports (rai::work_kernel const & kernel_a)
+{
+	auto result (false);
+	if (kernel_a.values != nullptr)
+	{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		if (&kernel_a == &rai::work_kernel_avx512)
+		{
+			result = __builtin_cpu_supports ("avx512f");
+		}
+		else if (&kernel_a == &rai::work_kernel_avx2)
+		{
+			result = __builtin_cpu_supports ("avx2");
+		}
+#endif
+	}
+	return result;
+}
+}
+
+void rai::work_root_init (rai::work_root & root_a, uint8_t const * bytes_a)
+{
+	// The hashed message is the 8 byte nonce followed by the 32 byte root, padded with zeros to one block
+	root_a.m[0] = 0;
+	for (auto i (0); i < 4; ++i)
+	{
+		uint64_t word (0);
+		for (auto j (0); j < 8; ++j)
+		{
+			word |= static_cast<uint64_t> (bytes_a[i * 8 + j]) << (j * 8);
+		}
+		root_a.m[1 + i] = word;
+	}
+	for (auto i (5); i < 16; ++i)
+	{
+		root_a.m[i] = 0;
+	}
+	root_a.v[0] = rai::work_blake2b::h0;
+	for (auto i (1); i < 8; ++i)
+	{
+		root_a.v[i] = rai::work_blake2b::iv[i];
+	}
+	for (auto i (0); i < 8; ++i)
+	{
+		root_a.v[8 + i] = rai::work_blake2b::iv[i];
+	}
+	// Message length and final block flag
+	root_a.v[12] ^= 8 + 32;
+	root_a.v[14] = ~root_a.v[14];
+	auto & m (root_a.m);
+	auto & v (root_a.v);
+	rai::work_blake2b::g<scalar_lanes> (v[1], v[5], v[9], v[13], m[2], m[3]);
+	rai::work_blake2b::g<scalar_lanes> (v[2], v[6], v[10], v[14], m[4], m[5]);
+	rai::work_blake2b::g<scalar_lanes> (v[3], v[7], v[11], v[15], m[6], m[7]);
+}
+
+std::vector<rai::work_kernel> rai::work_kernels ()
+{
+	std::vector<rai::work_kernel> result;
+	for (auto kernel : { &rai::work_kernel_avx512, &rai::work_kernel_avx2 })
+	{
+		if (cpu_supports (*kernel))
+		{
+			result.push_back (*kernel);
+		}
+	}
+	result.push_back (rai::work_kernel{ "portable", scalar_lanes::count, &values_scalar });
+	return result;
+}
+
 uint64_t rai::work_value (rai::block_hash const & root_a, uint64_t work_a)
 {
 	uint64_t result;
@@ -27,11 +136,11 @@ uint64_t rai::work_value (rai::block_hash const & root_a, uint64_t work_a)
 }
 
 rai::work_pool::work_pool (unsigned max_threads_a, std::function<boost::optional<uint64_t> (rai::uint256_union const &)> opencl_a) :
-ticket (0),
 done (false),
-opencl (opencl_a)
+sequence (0),
+opencl (opencl_a),
+kernel (rai::work_kernels ().front ())
 {
-	static_assert (ATOMIC_INT_LOCK_FREE == 2, "Atomic int needed");
 	auto count (rai::banano_network == rai::banano_networks::banano_test_network ? 1 : std::min (max_threads_a, std::max (1u, std::thread::hardware_concurrency ())));
 	for (auto i (0); i < count; ++i)
 	{
@@ -52,6 +161,62 @@ rai::work_pool::~work_pool ()
 	}
 }
 
+// Threads go to the most urgent class and spread across its requests, oldest first
+std::shared_ptr<rai::work_item> rai::work_pool::select ()
+{
+	assert (!mutex.try_lock ());
+	std::shared_ptr<rai::work_item> result;
+	for (auto & i : pending)
+	{
+		auto & item (i.second);
+		if (result == nullptr || item->priority < result->priority || (item->priority == result->priority && (item->threads < result->threads || (item->threads == result->threads && item->sequence < result->sequence))))
+		{
+			result = item;
+		}
+	}
+	return result;
+}
+
+void rai::work_pool::finish (std::unique_lock<std::mutex> & lock_a, std::shared_ptr<rai::work_item> item_a, boost::optional<uint64_t> const & work_a)
+{
+	assert (lock_a.owns_lock ());
+	// The lock is released while calling back so another thread may have finished the item in the meantime
+	if (!item_a->finished)
+	{
+		item_a->finished = true;
+		pending.erase (item_a->root);
+		auto now (std::chrono::steady_clock::now ());
+		auto started (item_a->started == std::chrono::steady_clock::time_point () ? now : item_a->started);
+		rai::work_stats stats{ item_a->root, item_a->priority, !!work_a, std::chrono::duration_cast<std::chrono::microseconds> (started - item_a->queued), std::chrono::duration_cast<std::chrono::microseconds> (now - started) };
+		std::vector<std::function<void(boost::optional<uint64_t> const &)>> callbacks;
+		callbacks.swap (item_a->callbacks);
+		lock_a.unlock ();
+		for (auto & i : callbacks)
+		{
+			i (work_a);
+		}
+		request_observers (stats);
+		lock_a.lock ();
+	}
+}
+
+void rai::work_pool::expire (std::unique_lock<std::mutex> & lock_a)
+{
+	auto now (std::chrono::steady_clock::now ());
+	std::vector<std::shared_ptr<rai::work_item>> expired;
+	for (auto & i : pending)
+	{
+		if (i.second->deadline < now)
+		{
+			expired.push_back (i.second);
+		}
+	}
+	for (auto & i : expired)
+	{
+		finish (lock_a, i, boost::none);
+	}
+}
+
 void rai::work_pool::loop (uint64_t thread)
 {
 	// Quick RNG for work attempts.
@@ -59,11 +224,14 @@ void rai::work_pool::loop (uint64_t thread)
 	rai::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (rng.s.data ()), rng.s.size () * sizeof (decltype (rng.s)::value_type));
 	uint64_t work;
 	uint64_t output;
-	blake2b_state hash;
-	blake2b_init (&hash, sizeof (output));
+	uint64_t nonces[8];
+	uint64_t values[8];
+	assert (kernel.lanes <= sizeof (nonces) / sizeof (nonces[0]));
+	rai::work_root root;
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!done || !pending.empty ())
 	{
+		expire (lock);
 		auto empty (pending.empty ());
 		if (thread == 0)
 		{
@@ -72,12 +240,18 @@ void rai::work_pool::loop (uint64_t thread)
 		}
 		if (!empty)
 		{
-			auto current_l (pending.front ());
-			int ticket_l (ticket);
+			auto item (select ());
+			++item->threads;
+			if (item->started == std::chrono::steady_clock::time_point ())
+			{
+				item->started = std::chrono::steady_clock::now ();
+			}
 			lock.unlock ();
+			rai::work_root_init (root, item->root.bytes.data ());
 			output = 0;
-			// ticket != ticket_l indicates a different thread found a solution and we should stop
-			while (ticket == ticket_l && output < rai::work_pool::publish_threshold)
+			// Work in slices so threads move to more urgent requests as they arrive
+			auto slice_end (std::chrono::steady_clock::now () + std::chrono::milliseconds (10));
+			while (!item->finished && output < rai::work_pool::publish_threshold && std::chrono::steady_clock::now () < slice_end)
 			{
 				// Don't query main memory every iteration in order to reduce memory bus traffic
 				// All operations here operate on stack memory
@@ -85,28 +259,26 @@ void rai::work_pool::loop (uint64_t thread)
 				unsigned iteration (256);
 				while (iteration && output < rai::work_pool::publish_threshold)
 				{
-					work = rng.next ();
-					blake2b_update (&hash, reinterpret_cast<uint8_t *> (&work), sizeof (work));
-					blake2b_update (&hash, current_l.first.bytes.data (), current_l.first.bytes.size ());
-					blake2b_final (&hash, reinterpret_cast<uint8_t *> (&output), sizeof (output));
-					blake2b_init (&hash, sizeof (output));
+					for (size_t i (0); i < kernel.lanes; ++i)
+					{
+						nonces[i] = rng.next ();
+					}
+					kernel.values (root, nonces, values);
+					for (size_t i (0); i < kernel.lanes && output < rai::work_pool::publish_threshold; ++i)
+					{
+						work = nonces[i];
+						output = values[i];
+					}
 					iteration -= 1;
 				}
 			}
 			lock.lock ();
-			if (ticket == ticket_l)
-			{
-				// If the ticket matches what we started with, we're the ones that found the solution
-				assert (output >= rai::work_pool::publish_threshold);
-				assert (work_value (current_l.first, work) == output);
-				// Signal other threads to stop their work next time they check ticket
-				++ticket;
-				current_l.second (work);
-				pending.pop_front ();
-			}
-			else
+			--item->threads;
+			if (output >= rai::work_pool::publish_threshold)
 			{
-				// A different thread found a solution
+				// First thread to find a solution, the others stop next time they check finished
+				assert (work_value (item->root, work) == output);
+				finish (lock, item, work);
 			}
 		}
 		else
@@ -119,27 +291,12 @@ void rai::work_pool::loop (uint64_t thread)
 
 void rai::work_pool::cancel (rai::uint256_union const & root_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	if (!pending.empty ())
+	std::unique_lock<std::mutex> lock (mutex);
+	auto existing (pending.find (root_a));
+	if (existing != pending.end ())
 	{
-		if (pending.front ().first == root_a)
-		{
-			++ticket;
-		}
+		finish (lock, existing->second, boost::none);
 	}
-	pending.remove_if ([&root_a](decltype (pending)::value_type const & item_a) {
-		bool result;
-		if (item_a.first == root_a)
-		{
-			item_a.second (boost::none);
-			result = true;
-		}
-		else
-		{
-			result = false;
-		}
-		return result;
-	});
 }
 
 void rai::work_pool::stop ()
@@ -149,7 +306,7 @@ void rai::work_pool::stop ()
 	producer_condition.notify_all ();
 }
 
-void rai::work_pool::generate (rai::uint256_union const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a)
+void rai::work_pool::generate (rai::uint256_union const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, rai::work_priority priority_a, std::chrono::steady_clock::time_point deadline_a)
 {
 	assert (!root_a.is_zero ());
 	boost::optional<uint64_t> result;
@@ -160,7 +317,25 @@ void rai::work_pool::generate (rai::uint256_union const & root_a, std::function<
 	if (!result)
 	{
 		std::lock_guard<std::mutex> lock (mutex);
-		pending.push_back (std::make_pair (root_a, callback_a));
+		auto & item (pending[root_a]);
+		if (item == nullptr)
+		{
+			item = std::make_shared<rai::work_item> ();
+			item->root = root_a;
+			item->priority = priority_a;
+			item->sequence = sequence++;
+			item->queued = std::chrono::steady_clock::now ();
+			item->deadline = deadline_a;
+			item->finished = false;
+			item->threads = 0;
+		}
+		else
+		{
+			// Joining requests keep the more urgent priority and the later deadline
+			item->priority = std::min (item->priority, priority_a);
+			item->deadline = std::max (item->deadline, deadline_a);
+		}
+		item->callbacks.push_back (callback_a);
 		producer_condition.notify_all ();
 	}
 	else
@@ -169,12 +344,19 @@ void rai::work_pool::generate (rai::uint256_union const & root_a, std::function<
 	}
 }
 
-uint64_t rai::work_pool::generate (rai::uint256_union const & hash_a)
+uint64_t rai::work_pool::generate (rai::uint256_union const & hash_a, rai::work_priority priority_a)
 {
 	std::promise<boost::optional<uint64_t>> work;
 	generate (hash_a, [&work](boost::optional<uint64_t> work_a) {
 		work.set_value (work_a);
-	});
+	},
+	priority_a);
 	auto result (work.get_future ().get ());
 	return result.value ();
 }
+
+size_t rai::work_pool::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return pending.size ();
+}
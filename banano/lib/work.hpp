@@ -4,11 +4,14 @@
 #include <banano/config.hpp>
 #include <banano/lib/numbers.hpp>
 #include <banano/lib/utility.hpp>
+#include <banano/lib/work_kernel.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <thread>
+#include <unordered_map>
 
 namespace rai
 {
@@ -16,7 +19,40 @@ class block;
 bool work_validate (rai::block_hash const &, uint64_t);
 bool work_validate (rai::block const &);
 uint64_t work_value (rai::block_hash const &, uint64_t);
+// Nonce search kernels usable on this CPU, fastest first. The portable kernel is always last
+std::vector<rai::work_kernel> work_kernels ();
 class opencl_work;
+// Requests in a more urgent class are always worked on first
+enum class work_priority : uint8_t
+{
+	wallet = 0,
+	rpc = 1,
+	precache = 2
+};
+class work_item
+{
+public:
+	rai::uint256_union root;
+	rai::work_priority priority;
+	uint64_t sequence;
+	std::chrono::steady_clock::time_point queued;
+	std::chrono::steady_clock::time_point started;
+	std::chrono::steady_clock::time_point deadline;
+	std::vector<std::function<void(boost::optional<uint64_t> const &)>> callbacks;
+	// Set once solved or cancelled, threads still working on the item stop at their next check
+	std::atomic<bool> finished;
+	unsigned threads;
+};
+class work_stats
+{
+public:
+	rai::uint256_union root;
+	rai::work_priority priority;
+	bool solved;
+	// Time until a thread started on the request and time spent on it after that
+	std::chrono::microseconds queue_time;
+	std::chrono::microseconds solve_time;
+};
 class work_pool
 {
 public:
@@ -25,16 +61,23 @@ public:
 	void loop (uint64_t);
 	void stop ();
 	void cancel (rai::uint256_union const &);
-	void generate (rai::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>);
-	uint64_t generate (rai::uint256_union const &);
-	std::atomic<int> ticket;
+	// Requests for a root which is already pending share its result, a past deadline cancels the request
+	void generate (rai::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>, rai::work_priority = rai::work_priority::wallet, std::chrono::steady_clock::time_point = std::chrono::steady_clock::time_point::max ());
+	uint64_t generate (rai::uint256_union const &, rai::work_priority = rai::work_priority::wallet);
+	size_t size ();
+	std::shared_ptr<rai::work_item> select ();
+	void finish (std::unique_lock<std::mutex> &, std::shared_ptr<rai::work_item>, boost::optional<uint64_t> const &);
+	void expire (std::unique_lock<std::mutex> &);
 	bool done;
 	std::vector<std::thread> threads;
-	std::list<std::pair<rai::uint256_union, std::function<void(boost::optional<uint64_t> const &)>>> pending;
+	std::unordered_map<rai::uint256_union, std::shared_ptr<rai::work_item>> pending;
+	uint64_t sequence;
 	std::mutex mutex;
 	std::condition_variable producer_condition;
 	std::function<boost::optional<uint64_t> (rai::uint256_union const &)> opencl;
+	rai::work_kernel kernel;
 	rai::observer_set<bool> work_observers;
+	rai::observer_set<rai::work_stats const &> request_observers;
 	// Local work threshold for rate-limiting publishing blocks. ~5 seconds of work.
 	static uint64_t const publish_test_threshold = 0xff00000000000000;
 	static uint64_t const publish_full_threshold = 0xfffffe0000000000;
@@ -0,0 +1,69 @@
+#include <banano/lib/work_kernel.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+class avx2_lanes
+{
+public:
+	using vec = __m256i;
+	static size_t constexpr count = 4;
+	static vec load (uint64_t const * data_a)
+	{
+		return _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (data_a));
+	}
+	static void store (uint64_t * data_a, vec value_a)
+	{
+		_mm256_storeu_si256 (reinterpret_cast<__m256i *> (data_a), value_a);
+	}
+	static vec set1 (uint64_t value_a)
+	{
+		return _mm256_set1_epi64x (static_cast<long long> (value_a));
+	}
+	static vec add (vec a, vec b)
+	{
+		return _mm256_add_epi64 (a, b);
+	}
+	static vec bxor (vec a, vec b)
+	{
+		return _mm256_xor_si256 (a, b);
+	}
+	template <int N>
+	static vec rotr (vec a)
+	{
+		return _mm256_or_si256 (_mm256_srli_epi64 (a, N), _mm256_slli_epi64 (a, 64 - N));
+	}
+};
+template <>
+__m256i avx2_lanes::rotr<32> (__m256i a)
+{
+	return _mm256_shuffle_epi32 (a, _MM_SHUFFLE (2, 3, 0, 1));
+}
+template <>
+__m256i avx2_lanes::rotr<24> (__m256i a)
+{
+	return _mm256_shuffle_epi8 (a, _mm256_setr_epi8 (3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10));
+}
+template <>
+__m256i avx2_lanes::rotr<16> (__m256i a)
+{
+	return _mm256_shuffle_epi8 (a, _mm256_setr_epi8 (2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9));
+}
+template <>
+__m256i avx2_lanes::rotr<63> (__m256i a)
+{
+	return _mm256_or_si256 (_mm256_srli_epi64 (a, 63), _mm256_add_epi64 (a, a));
+}
+
+void values_avx2 (rai::work_root const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	rai::work_blake2b::values<avx2_lanes> (root_a, nonces_a, values_a);
+}
+}
+
+rai::work_kernel const rai::work_kernel_avx2 = { "avx2", avx2_lanes::count, &values_avx2 };
+#else
+rai::work_kernel const rai::work_kernel_avx2 = { "avx2", 4, nullptr };
+#endif
@@ -0,0 +1,49 @@
+#include <banano/lib/work_kernel.hpp>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace
+{
+class avx512_lanes
+{
+public:
+	using vec = __m512i;
+	static size_t constexpr count = 8;
+	static vec load (uint64_t const * data_a)
+	{
+		return _mm512_loadu_si512 (data_a);
+	}
+	static void store (uint64_t * data_a, vec value_a)
+	{
+		_mm512_storeu_si512 (data_a, value_a);
+	}
+	static vec set1 (uint64_t value_a)
+	{
+		return _mm512_set1_epi64 (static_cast<long long> (value_a));
+	}
+	static vec add (vec a, vec b)
+	{
+		return _mm512_add_epi64 (a, b);
+	}
+	static vec bxor (vec a, vec b)
+	{
+		return _mm512_xor_si512 (a, b);
+	}
+	template <int N>
+	static vec rotr (vec a)
+	{
+		return _mm512_ror_epi64 (a, N);
+	}
+};
+
+void values_avx512 (rai::work_root const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	rai::work_blake2b::values<avx512_lanes> (root_a, nonces_a, values_a);
+}
+}
+
+rai::work_kernel const rai::work_kernel_avx512 = { "avx512", avx512_lanes::count, &values_avx512 };
+#else
+rai::work_kernel const rai::work_kernel_avx512 = { "avx512", 8, nullptr };
+#endif
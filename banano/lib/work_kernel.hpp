@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Included by translation units built with CPU specific flags, keep this free of inline code with external linkage
+namespace rai
+{
+// Blake2b state shared by every nonce tried against one root
+class work_root
+{
+public:
+	// Message words, word 0 is the nonce
+	uint64_t m[16];
+	// Working vector after the round 0 column steps which don't involve the nonce
+	uint64_t v[16];
+};
+void work_root_init (rai::work_root &, uint8_t const *);
+class work_kernel
+{
+public:
+	char const * name;
+	size_t lanes;
+	// Writes work_value of each of lanes nonces, null if the kernel wasn't compiled in
+	void (*values) (rai::work_root const &, uint64_t const *, uint64_t *);
+};
+extern rai::work_kernel const work_kernel_avx2;
+extern rai::work_kernel const work_kernel_avx512;
+namespace work_blake2b
+{
+	uint64_t constexpr iv[8] = { 0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL };
+	// 8 byte digest, no key, fanout and depth of 1
+	uint64_t constexpr h0 = iv[0] ^ 0x01010008ULL;
+	uint8_t constexpr sigma[10][16] = {
+		{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+		{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+		{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+		{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+		{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+		{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+		{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+		{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+		{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+		{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 }
+	};
+	// Lanes supplies a vector type holding one 64 bit word per nonce and the operations on it
+	template <typename Lanes>
+	inline void g (typename Lanes::vec & a, typename Lanes::vec & b, typename Lanes::vec & c, typename Lanes::vec & d, typename Lanes::vec const & x, typename Lanes::vec const & y)
+	{
+		a = Lanes::add (Lanes::add (a, b), x);
+		d = Lanes::template rotr<32> (Lanes::bxor (d, a));
+		c = Lanes::add (c, d);
+		b = Lanes::template rotr<24> (Lanes::bxor (b, c));
+		a = Lanes::add (Lanes::add (a, b), y);
+		d = Lanes::template rotr<16> (Lanes::bxor (d, a));
+		c = Lanes::add (c, d);
+		b = Lanes::template rotr<63> (Lanes::bxor (b, c));
+	}
+	template <typename Lanes>
+	inline void diagonals (typename Lanes::vec * v, typename Lanes::vec const * m, uint8_t const * s)
+	{
+		g<Lanes> (v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+		g<Lanes> (v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+		g<Lanes> (v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+		g<Lanes> (v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+	}
+	template <typename Lanes>
+	inline void round (typename Lanes::vec * v, typename Lanes::vec const * m, uint8_t const * s)
+	{
+		g<Lanes> (v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+		g<Lanes> (v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+		g<Lanes> (v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+		g<Lanes> (v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+		diagonals<Lanes> (v, m, s);
+	}
+	// Hashes Lanes::count nonces against the precomputed root, the result matches rai::work_value
+	template <typename Lanes>
+	inline void values (rai::work_root const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+	{
+		typename Lanes::vec m[16];
+		typename Lanes::vec v[16];
+		m[0] = Lanes::load (nonces_a);
+		for (auto i (1); i < 16; ++i)
+		{
+			m[i] = Lanes::set1 (root_a.m[i]);
+		}
+		for (auto i (0); i < 16; ++i)
+		{
+			v[i] = Lanes::set1 (root_a.v[i]);
+		}
+		// Only the first column step of round 0 reads the nonce
+		g<Lanes> (v[0], v[4], v[8], v[12], m[0], m[1]);
+		diagonals<Lanes> (v, m, sigma[0]);
+		for (auto i (1); i < 12; ++i)
+		{
+			round<Lanes> (v, m, sigma[i % 10]);
+		}
+		Lanes::store (values_a, Lanes::bxor (Lanes::set1 (h0), Lanes::bxor (v[0], v[8])));
+	}
+}
+}
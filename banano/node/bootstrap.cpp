@@ -12,6 +12,19 @@ constexpr double bootstrap_minimum_frontier_blocks_per_sec = 1000.0;
 constexpr unsigned bootstrap_frontier_retry_limit = 16;
 constexpr double bootstrap_minimum_termination_time_sec = 30.0;
 constexpr unsigned bootstrap_max_new_connections = 10;
+constexpr size_t bootstrap_pull_batch_max = 16;
+constexpr double bootstrap_duplicate_age_sec = 10.0;
+constexpr unsigned bootstrap_max_duplicates = 4;
+
+size_t constexpr rai::frontier_req_client::receive_chunk;
+size_t constexpr rai::frontier_req_client::unsynced_max;
+size_t constexpr rai::bulk_pull_client::receive_chunk;
+size_t constexpr rai::bulk_pull_server::batch_max;
+size_t constexpr rai::frontier_req_server::batch_max;
+std::chrono::milliseconds constexpr rai::frontier_req_server::batch_time;
+double constexpr rai::bootstrap_peer_scores::rate_weight;
+uint64_t constexpr rai::bootstrap_peer_scores::trusted_pulls;
+size_t constexpr rai::bootstrap_peer_scores::max_peers;
 
 rai::block_synchronization::block_synchronization (boost::log::sources::logger_mt & log_a) :
 log (log_a)
@@ -303,10 +316,15 @@ std::shared_ptr<rai::bootstrap_client> rai::bootstrap_client::shared ()
 rai::frontier_req_client::frontier_req_client (std::shared_ptr<rai::bootstrap_client> connection_a) :
 connection (connection_a),
 current (0),
-count (0)
+count (0),
+receive_size (0)
 {
 	rai::transaction transaction (connection->node->store.environment, nullptr, false);
-	next (transaction);
+	auto i (connection->node->store.latest_begin (transaction));
+	if (i != connection->node->store.latest_end ())
+	{
+		current = rai::account (i->first.uint256 ());
+	}
 }
 
 rai::frontier_req_client::~frontier_req_client ()
@@ -315,15 +333,18 @@ rai::frontier_req_client::~frontier_req_client ()
 
 void rai::frontier_req_client::receive_frontier ()
 {
+	if (receive_buffer.size () < receive_size + receive_chunk)
+	{
+		receive_buffer.resize (receive_size + receive_chunk);
+	}
 	auto this_l (shared_from_this ());
 	connection->start_timeout ();
-	size_t size_l (sizeof (rai::uint256_union) + sizeof (rai::uint256_union));
-	boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data (), size_l), [this_l, size_l](boost::system::error_code const & ec, size_t size_a) {
+	connection->socket.async_read_some (boost::asio::buffer (receive_buffer.data () + receive_size, receive_chunk), [this_l](boost::system::error_code const & ec, size_t size_a) {
 		this_l->connection->stop_timeout ();
 
 		// An issue with asio is that sometimes, instead of reporting a bad file descriptor during disconnect,
 		// we simply get a size of 0.
-		if (size_a == size_l)
+		if (size_a != 0 || ec)
 		{
 			this_l->received_frontier (ec, size_a);
 		}
@@ -331,132 +352,175 @@ void rai::frontier_req_client::receive_frontier ()
 		{
 			if (this_l->connection->node->config.logging.network_message_logging ())
 			{
-				BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("Invalid size: expected %1%, got %2%") % size_l % size_a);
+				BOOST_LOG (this_l->connection->node->log) << "Invalid size: got 0 frontier bytes";
 			}
 		}
 	});
 }
 
-void rai::frontier_req_client::unsynced (MDB_txn * transaction_a, rai::block_hash const & ours_a, rai::block_hash const & theirs_a)
+void rai::frontier_req_client::unsynced (rai::block_hash const & ours_a, rai::block_hash const & theirs_a)
 {
-	auto current (ours_a);
-	while (!current.is_zero () && current != theirs_a)
+	unsynced_heads.push_back (std::make_pair (ours_a, theirs_a));
+}
+
+// Walks every queued wallet account head back to the peer's frontier marking blocks unsynced, all in one write transaction
+void rai::frontier_req_client::flush_unsynced ()
+{
+	if (!unsynced_heads.empty ())
 	{
-		connection->node->store.unsynced_put (transaction_a, current);
-		auto block (connection->node->store.block_get (transaction_a, current));
-		current = block->previous ();
+		rai::transaction transaction (connection->node->store.environment, nullptr, true);
+		for (auto & i : unsynced_heads)
+		{
+			auto hash (i.first);
+			while (!hash.is_zero () && hash != i.second)
+			{
+				connection->node->store.unsynced_put (transaction, hash);
+				auto block (connection->node->store.block_get (transaction, hash));
+				// The chain may have been rolled back since it was compared
+				hash = block != nullptr ? block->previous () : rai::block_hash (0);
+			}
+		}
+		unsynced_heads.clear ();
 	}
 }
 
-void rai::frontier_req_client::received_frontier (boost::system::error_code const & ec, size_t size_a)
+/**
+ * Merge every complete frontier in the receive buffer against the local accounts table with one cursor under a read transaction,
+ * leaving any partial frontier at the front for the next read. Returns true once the terminating zero account has been read
+ */
+bool rai::frontier_req_client::compare_frontiers (std::vector<rai::pull_info> & pulls_a)
 {
-	if (!ec)
+	auto result (false);
+	size_t constexpr frontier_size (sizeof (rai::uint256_union) + sizeof (rai::uint256_union));
+	size_t position (0);
+	auto & store (connection->node->store);
+	auto & wallets (connection->node->wallets);
+	rai::transaction transaction (store.environment, nullptr, false);
+	auto n (store.latest_end ());
+	auto i (current.is_zero () ? store.latest_end () : store.latest_begin (transaction, current));
+	while (!result && position + frontier_size <= receive_size)
 	{
-		assert (size_a == sizeof (rai::uint256_union) + sizeof (rai::uint256_union));
 		rai::account account;
-		rai::bufferstream account_stream (connection->receive_buffer.data (), sizeof (rai::uint256_union));
+		rai::bufferstream account_stream (receive_buffer.data () + position, sizeof (rai::uint256_union));
 		auto error1 (rai::read (account_stream, account));
 		assert (!error1);
 		rai::block_hash latest;
-		rai::bufferstream latest_stream (connection->receive_buffer.data () + sizeof (rai::uint256_union), sizeof (rai::uint256_union));
+		rai::bufferstream latest_stream (receive_buffer.data () + position + sizeof (rai::uint256_union), sizeof (rai::uint256_union));
 		auto error2 (rai::read (latest_stream, latest));
 		assert (!error2);
-		if (count == 0)
-		{
-			start_time = std::chrono::steady_clock::now ();
-		}
-		++count;
-		std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - start_time);
-		double elapsed_sec = time_span.count ();
-		double blocks_per_sec = (double)count / elapsed_sec;
-		if (elapsed_sec > bootstrap_connection_warmup_time_sec && blocks_per_sec < bootstrap_minimum_frontier_blocks_per_sec)
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Aborting frontier req because it was too slow"));
-			promise.set_value (true);
-			return;
-		}
-		if (connection->attempt->should_log ())
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Received %1% frontiers from %2%") % std::to_string (count) % connection->socket.remote_endpoint ());
-		}
+		position += frontier_size;
 		if (!account.is_zero ())
 		{
-			while (!current.is_zero () && current < account)
+			++count;
+			for (; i != n && rai::account (i->first.uint256 ()) < account; ++i)
 			{
 				// We know about an account they don't.
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
-				if (connection->node->wallets.exists (transaction, current))
+				if (wallets.exists (transaction, rai::account (i->first.uint256 ())))
 				{
-					unsynced (transaction, info.head, 0);
+					unsynced (rai::account_info (i->second).head, 0);
 				}
-				next (transaction);
 			}
-			if (!current.is_zero ())
+			if (i != n && rai::account (i->first.uint256 ()) == account)
 			{
-				if (account == current)
+				rai::account_info info (i->second);
+				if (latest == info.head)
 				{
-					rai::transaction transaction (connection->node->store.environment, nullptr, true);
-					if (latest == info.head)
+					// In sync
+				}
+				else
+				{
+					if (store.block_exists (transaction, latest))
 					{
-						// In sync
+						// We know about a block they don't.
+						if (wallets.exists (transaction, account))
+						{
+							unsynced (info.head, latest);
+						}
 					}
 					else
 					{
-						if (connection->node->store.block_exists (transaction, latest))
-						{
-							// We know about a block they don't.
-							if (connection->node->wallets.exists (transaction, current))
-							{
-								unsynced (transaction, info.head, latest);
-							}
-						}
-						else
-						{
-							connection->attempt->add_pull (rai::pull_info (account, latest, info.head));
-						}
+						pulls_a.push_back (rai::pull_info (account, latest, info.head));
 					}
-					next (transaction);
-				}
-				else
-				{
-					assert (account < current);
-					connection->attempt->add_pull (rai::pull_info (account, latest, rai::block_hash (0)));
 				}
+				++i;
 			}
 			else
 			{
-				connection->attempt->add_pull (rai::pull_info (account, latest, rai::block_hash (0)));
+				pulls_a.push_back (rai::pull_info (account, latest, rai::block_hash (0)));
 			}
-			receive_frontier ();
 		}
 		else
 		{
+			for (; i != n; ++i)
 			{
-				rai::transaction transaction (connection->node->store.environment, nullptr, true);
-				while (!current.is_zero ())
+				// We know about an account they don't.
+				if (wallets.exists (transaction, rai::account (i->first.uint256 ())))
 				{
-					// We know about an account they don't.
-					if (connection->node->wallets.exists (transaction, current))
-					{
-						unsynced (transaction, info.head, 0);
-					}
-					next (transaction);
+					unsynced (rai::account_info (i->second).head, 0);
 				}
 			}
+			result = true;
+		}
+	}
+	current = i != n ? rai::account (i->first.uint256 ()) : rai::account (0);
+	std::copy (receive_buffer.begin () + position, receive_buffer.begin () + receive_size, receive_buffer.begin ());
+	receive_size -= position;
+	return result;
+}
+
+void rai::frontier_req_client::received_frontier (boost::system::error_code const & ec, size_t size_a)
+{
+	if (!ec)
+	{
+		if (count == 0)
+		{
+			start_time = std::chrono::steady_clock::now ();
+		}
+		receive_size += size_a;
+		std::vector<rai::pull_info> pulls;
+		auto done (compare_frontiers (pulls));
+		if (!pulls.empty ())
+		{
+			connection->attempt->add_pull (pulls);
+		}
+		std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - start_time);
+		double elapsed_sec = time_span.count ();
+		double blocks_per_sec = (double)count / elapsed_sec;
+		auto slow (!done && elapsed_sec > bootstrap_connection_warmup_time_sec && blocks_per_sec < bootstrap_minimum_frontier_blocks_per_sec);
+		if (done || slow || unsynced_heads.size () >= unsynced_max)
+		{
+			flush_unsynced ();
+		}
+		if (slow)
+		{
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Aborting frontier req because it was too slow"));
+			promise.set_value (true);
+			return;
+		}
+		if (connection->attempt->should_log ())
+		{
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Received %1% frontiers from %2%") % std::to_string (count) % connection->socket.remote_endpoint ());
+		}
+		if (!done)
+		{
+			receive_frontier ();
+		}
+		else
+		{
+			try
+			{
+				promise.set_value (false);
+			}
+			catch (std::future_error &)
 			{
-				try
-				{
-					promise.set_value (false);
-				}
-				catch (std::future_error &)
-				{
-				}
-				connection->attempt->pool_connection (connection);
 			}
+			connection->attempt->pool_connection (connection);
 		}
 	}
 	else
 	{
+		// Walks queued from frontiers already received are still valid
+		flush_unsynced ();
 		if (connection->node->config.logging.network_logging ())
 		{
 			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error while receiving frontier %1%") % ec.message ());
@@ -464,25 +528,18 @@ void rai::frontier_req_client::received_frontier (boost::system::error_code cons
 	}
 }
 
-void rai::frontier_req_client::next (MDB_txn * transaction_a)
-{
-	auto iterator (connection->node->store.latest_begin (transaction_a, rai::uint256_union (current.number () + 1)));
-	if (iterator != connection->node->store.latest_end ())
-	{
-		current = rai::account (iterator->first.uint256 ());
-		info = rai::account_info (iterator->second);
-	}
-	else
-	{
-		current.clear ();
-	}
-}
-
 rai::bulk_pull_client::bulk_pull_client (std::shared_ptr<rai::bootstrap_client> connection_a, rai::pull_info const & pull_a) :
 connection (connection_a),
-pull (pull_a)
+pull (pull_a),
+pull_blocks (0),
+speculative (false),
+duplicated (false),
+superseded (false),
+receive_size (0),
+finished (false)
 {
 	std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
+	pull_start = std::chrono::steady_clock::now ();
 	++connection->attempt->pulling;
 	connection->attempt->condition.notify_all ();
 }
@@ -492,13 +549,21 @@ rai::bulk_pull_client::~bulk_pull_client ()
 	// If received end block is not expected end block
 	if (expected != pull.end)
 	{
-		pull.head = expected;
-		connection->attempt->requeue_pull (pull);
-		if (connection->node->config.logging.bulk_pull_logging ())
+		score (!superseded);
+		if (!speculative && !superseded)
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull end block is not expected %1% for account %2%") % pull.end.to_string () % pull.account.to_account ());
+			pull.head = expected;
+			connection->attempt->requeue_pull (pull);
+			if (connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull end block is not expected %1% for account %2%") % pull.end.to_string () % pull.account.to_account ());
+			}
 		}
 	}
+	if (!batch.empty ())
+	{
+		connection->attempt->add_pull (std::vector<rai::pull_info> (batch.begin (), batch.end ()));
+	}
 	std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
 	--connection->attempt->pulling;
 	connection->attempt->condition.notify_all ();
@@ -545,140 +610,221 @@ void rai::bulk_pull_client::request ()
 
 void rai::bulk_pull_client::receive_block ()
 {
-	auto this_l (shared_from_this ());
-	connection->start_timeout ();
-	boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data (), 1), [this_l](boost::system::error_code const & ec, size_t size_a) {
-		this_l->connection->stop_timeout ();
-		if (!ec)
+	auto node_l (connection->node);
+	if (node_l->block_processor.saturated (rai::block_origin::bootstrap))
+	{
+		// Stop reading until the block processor catches up, the peer is held back by TCP flow control
+		auto this_l (shared_from_this ());
+		node_l->alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (100), [this_l]() {
+			if (!this_l->connection->hard_stop.load ())
+			{
+				this_l->receive_block ();
+			}
+		});
+	}
+	else
+	{
+		if (receive_buffer.size () < receive_size + receive_chunk)
 		{
-			this_l->received_type ();
+			receive_buffer.resize (receive_size + receive_chunk);
 		}
-		else
+		auto this_l (shared_from_this ());
+		connection->start_timeout ();
+		connection->socket.async_read_some (boost::asio::buffer (receive_buffer.data () + receive_size, receive_chunk), [this_l](boost::system::error_code const & ec, size_t size_a) {
+			this_l->connection->stop_timeout ();
+			this_l->received_data (ec, size_a);
+		});
+	}
+}
+
+void rai::bulk_pull_client::received_data (boost::system::error_code const & ec, size_t size_a)
+{
+	if (!ec)
+	{
+		receive_size += size_a;
+		std::vector<std::shared_ptr<rai::block>> blocks;
+		auto done (decode_blocks (blocks));
+		if (!blocks.empty ())
 		{
-			if (this_l->connection->node->config.logging.bulk_pull_logging ())
+			if (connection->block_count == 0)
 			{
-				BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("Error receiving block type: %1%") % ec.message ());
+				connection->start_time = std::chrono::steady_clock::now ();
+			}
+			std::vector<std::shared_ptr<rai::block>> dropped;
+			if (connection->attempt->node->block_processor.add (blocks, rai::block_origin::bootstrap, &dropped))
+			{
+				// Other clients filled the queue since this one checked it, the dropped blocks are a run ending at the oldest one received
+				// Pulls always start from the account head so pull again down to that oldest block, the newer ones come back as old
+				auto retry (pull);
+				retry.end = dropped.back ()->previous ();
+				connection->attempt->add_pull (retry);
+				if (connection->node->config.logging.bulk_pull_logging ())
+				{
+					BOOST_LOG (connection->node->log) << boost::str (boost::format ("Block processor dropped %1% blocks pulled for account %2%, pulling again") % dropped.size () % pull.account.to_account ());
+				}
 			}
+			auto added (blocks.size () - dropped.size ());
+			connection->block_count += added;
+			pull_blocks += added;
+			connection->attempt->total_blocks += added;
 		}
-	});
+		if (finished)
+		{
+			if (expected == pull.end)
+			{
+				score (false);
+				if (speculative)
+				{
+					// The original stops reading and isn't requeued
+					if (auto original_l = original.lock ())
+					{
+						original_l->superseded = true;
+					}
+				}
+			}
+			// Avoid re-using slow peers, or peers that sent the wrong blocks.
+			if (!connection->pending_stop && expected == pull.end)
+			{
+				auto next (false);
+				{
+					std::lock_guard<std::mutex> lock (connection->attempt->mutex);
+					if (!batch.empty ())
+					{
+						next = true;
+						pull = batch.front ();
+						batch.pop_front ();
+						pull_start = std::chrono::steady_clock::now ();
+					}
+				}
+				if (next)
+				{
+					finished = false;
+					pull_blocks = 0;
+					request ();
+				}
+				else
+				{
+					connection->attempt->pool_connection (connection);
+				}
+			}
+		}
+		else if (!done && !connection->hard_stop.load () && !superseded)
+		{
+			receive_block ();
+		}
+	}
+	else
+	{
+		if (connection->node->config.logging.bulk_pull_logging ())
+		{
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error bulk receiving block: %1%") % ec.message ());
+		}
+	}
 }
 
-void rai::bulk_pull_client::received_type ()
+namespace
 {
-	auto this_l (shared_from_this ());
-	rai::block_type type (static_cast<rai::block_type> (connection->receive_buffer[0]));
-	switch (type)
+// Size of a serialized block excluding the type byte, 0 if the type doesn't have a body
+size_t serialized_size (rai::block_type type_a)
+{
+	size_t result (0);
+	switch (type_a)
 	{
 		case rai::block_type::send:
-		{
-			connection->start_timeout ();
-			boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data () + 1, rai::send_block::size), [this_l](boost::system::error_code const & ec, size_t size_a) {
-				this_l->connection->stop_timeout ();
-				this_l->received_block (ec, size_a);
-			});
+			result = rai::send_block::size;
 			break;
-		}
 		case rai::block_type::receive:
-		{
-			connection->start_timeout ();
-			boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data () + 1, rai::receive_block::size), [this_l](boost::system::error_code const & ec, size_t size_a) {
-				this_l->connection->stop_timeout ();
-				this_l->received_block (ec, size_a);
-			});
+			result = rai::receive_block::size;
 			break;
-		}
 		case rai::block_type::open:
-		{
-			connection->start_timeout ();
-			boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data () + 1, rai::open_block::size), [this_l](boost::system::error_code const & ec, size_t size_a) {
-				this_l->connection->stop_timeout ();
-				this_l->received_block (ec, size_a);
-			});
+			result = rai::open_block::size;
 			break;
-		}
 		case rai::block_type::change:
-		{
-			connection->start_timeout ();
-			boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data () + 1, rai::change_block::size), [this_l](boost::system::error_code const & ec, size_t size_a) {
-				this_l->connection->stop_timeout ();
-				this_l->received_block (ec, size_a);
-			});
+			result = rai::change_block::size;
 			break;
-		}
 		case rai::block_type::state:
-		{
-			connection->start_timeout ();
-			boost::asio::async_read (connection->socket, boost::asio::buffer (connection->receive_buffer.data () + 1, rai::state_block::size), [this_l](boost::system::error_code const & ec, size_t size_a) {
-				this_l->connection->stop_timeout ();
-				this_l->received_block (ec, size_a);
-			});
+			result = rai::state_block::size;
 			break;
-		}
-		case rai::block_type::not_a_block:
-		{
-			// Avoid re-using slow peers, or peers that sent the wrong blocks.
-			if (!connection->pending_stop && expected == pull.end)
-			{
-				connection->attempt->pool_connection (connection);
-			}
-			break;
-		}
 		default:
-		{
-			if (connection->node->config.logging.network_packet_logging ())
-			{
-				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Unknown type received as block type: %1%") % static_cast<int> (type));
-			}
 			break;
-		}
 	}
+	return result;
+}
 }
 
-void rai::bulk_pull_client::received_block (boost::system::error_code const & ec, size_t size_a)
+void rai::bulk_pull_client::score (bool failed_a)
 {
-	if (!ec)
+	auto seconds (std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - pull_start).count ());
+	connection->node->bootstrap_initiator.peer_scores.pull_finished (rai::endpoint (connection->endpoint.address (), connection->endpoint.port ()), pull_blocks, seconds, failed_a);
+}
+
+/**
+ * Decode every complete block in the receive buffer, leaving any partial block at the front for the next read.
+ * Returns true if the pull ended, either with not_a_block or on bad data
+ */
+bool rai::bulk_pull_client::decode_blocks (std::vector<std::shared_ptr<rai::block>> & blocks_a)
+{
+	auto result (false);
+	size_t position (0);
+	while (!result && position < receive_size)
 	{
-		rai::bufferstream stream (connection->receive_buffer.data (), 1 + size_a);
-		std::shared_ptr<rai::block> block (rai::deserialize_block (stream));
-		if (block != nullptr && !rai::work_validate (*block))
+		rai::block_type type (static_cast<rai::block_type> (receive_buffer[position]));
+		if (type == rai::block_type::not_a_block)
 		{
-			auto hash (block->hash ());
-			if (connection->node->config.logging.bulk_pull_logging ())
-			{
-				std::string block_l;
-				block->serialize_json (block_l);
-				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
-			}
-			if (hash == expected)
-			{
-				expected = block->previous ();
-			}
-			if (connection->block_count++ == 0)
+			++position;
+			finished = true;
+			result = true;
+		}
+		else
+		{
+			auto size (serialized_size (type));
+			if (size == 0)
 			{
-				connection->start_time = std::chrono::steady_clock::now ();
+				if (connection->node->config.logging.network_packet_logging ())
+				{
+					BOOST_LOG (connection->node->log) << boost::str (boost::format ("Unknown type received as block type: %1%") % static_cast<int> (type));
+				}
+				result = true;
 			}
-			connection->attempt->total_blocks++;
-			connection->attempt->node->block_processor.add (block);
-			if (!connection->hard_stop.load ())
+			else if (position + 1 + size <= receive_size)
 			{
-				receive_block ();
+				rai::bufferstream stream (receive_buffer.data () + position, 1 + size);
+				std::shared_ptr<rai::block> block (rai::deserialize_block (stream));
+				if (block != nullptr && !rai::work_validate (*block))
+				{
+					auto hash (block->hash ());
+					if (connection->node->config.logging.bulk_pull_logging ())
+					{
+						std::string block_l;
+						block->serialize_json (block_l);
+						BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
+					}
+					if (hash == expected)
+					{
+						expected = block->previous ();
+					}
+					blocks_a.push_back (block);
+					position += 1 + size;
+				}
+				else
+				{
+					if (connection->node->config.logging.bulk_pull_logging ())
+					{
+						BOOST_LOG (connection->node->log) << "Error deserializing block received from pull request";
+					}
+					result = true;
+				}
 			}
-		}
-		else
-		{
-			if (connection->node->config.logging.bulk_pull_logging ())
+			else
 			{
-				BOOST_LOG (connection->node->log) << "Error deserializing block received from pull request";
+				// Partial block, wait for more data
+				break;
 			}
 		}
 	}
-	else
-	{
-		if (connection->node->config.logging.bulk_pull_logging ())
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error bulk receiving block: %1%") % ec.message ());
-		}
-	}
+	std::copy (receive_buffer.begin () + position, receive_buffer.begin () + receive_size, receive_buffer.begin ());
+	receive_size -= position;
+	return result;
 }
 
 rai::bulk_push_client::bulk_push_client (std::shared_ptr<rai::bootstrap_client> const & connection_a) :
@@ -889,21 +1035,104 @@ bool rai::bootstrap_attempt::request_frontier (std::unique_lock<std::mutex> & lo
 
 void rai::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock_a)
 {
-	auto connection_l (connection (lock_a));
+	// Retried pulls are the long or troublesome chains, they go alone to the fastest idle peer
+	auto connection_l (connection (lock_a, pulls.front ().attempts > 0));
 	if (connection_l)
 	{
 		auto pull (pulls.front ());
 		pulls.pop_front ();
-		auto size (pulls.size ());
+		std::deque<rai::pull_info> batch;
+		if (pull.attempts == 0)
+		{
+			// Fresh pulls are mostly small accounts, queue several on one connection while there are enough to go around
+			auto batch_size (std::min (bootstrap_pull_batch_max, pulls.size () / std::max (1U, connections.load ())));
+			while (batch.size () < batch_size && !pulls.empty () && pulls.front ().attempts == 0)
+			{
+				batch.push_back (pulls.front ());
+				pulls.pop_front ();
+			}
+		}
 		// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
 		// Dispatch request in an external thread in case it needs to be destroyed
-		node->background ([connection_l, pull, size]() {
+		node->background ([connection_l, pull, batch]() {
 			auto client (std::make_shared<rai::bulk_pull_client> (connection_l, pull));
+			client->batch = batch;
+			connection_l->attempt->add_in_flight (client);
 			client->request ();
 		});
 	}
 }
 
+// Once no pulls are left, race the longest running pull on the fastest idle peer in case its own peer is slow
+bool rai::bootstrap_attempt::request_duplicate (std::unique_lock<std::mutex> & lock_a)
+{
+	assert (!mutex.try_lock ());
+	auto result (false);
+	if (!idle.empty ())
+	{
+		auto now (std::chrono::steady_clock::now ());
+		unsigned duplicates (0);
+		// Clients are only released with the mutex unlocked since their destructor can requeue
+		std::vector<std::shared_ptr<rai::bulk_pull_client>> clients_l;
+		std::shared_ptr<rai::bulk_pull_client> oldest;
+		for (auto i (in_flight.begin ()); i != in_flight.end ();)
+		{
+			if (auto client = i->lock ())
+			{
+				if (client->speculative)
+				{
+					++duplicates;
+				}
+				else if (!client->duplicated && client->batch.empty () && std::chrono::duration_cast<std::chrono::duration<double>> (now - client->pull_start).count () > bootstrap_duplicate_age_sec && (oldest == nullptr || client->pull_start < oldest->pull_start))
+				{
+					oldest = client;
+				}
+				clients_l.push_back (client);
+				++i;
+			}
+			else
+			{
+				i = in_flight.erase (i);
+			}
+		}
+		if (oldest != nullptr && duplicates < bootstrap_max_duplicates)
+		{
+			auto existing (fastest_idle (oldest->connection->endpoint));
+			if (existing != idle.end ())
+			{
+				auto connection_l (*existing);
+				idle.erase (existing);
+				oldest->duplicated = true;
+				auto pull (oldest->pull);
+				std::weak_ptr<rai::bulk_pull_client> original (oldest);
+				if (node->config.logging.bulk_pull_logging ())
+				{
+					BOOST_LOG (node->log) << boost::str (boost::format ("Duplicating pull of account %1% from %2% on %3%") % pull.account.to_account () % oldest->connection->endpoint % connection_l->endpoint);
+				}
+				node->background ([connection_l, pull, original]() {
+					auto client (std::make_shared<rai::bulk_pull_client> (connection_l, pull));
+					client->speculative = true;
+					client->original = original;
+					connection_l->attempt->add_in_flight (client);
+					client->request ();
+				});
+				result = true;
+			}
+		}
+		oldest.reset ();
+		lock_a.unlock ();
+		clients_l.clear ();
+		lock_a.lock ();
+	}
+	return result;
+}
+
+void rai::bootstrap_attempt::add_in_flight (std::shared_ptr<rai::bulk_pull_client> client_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	in_flight.push_back (client_a);
+}
+
 bool rai::bootstrap_attempt::request_push (std::unique_lock<std::mutex> & lock_a)
 {
 	auto result (true);
@@ -964,9 +1193,9 @@ void rai::bootstrap_attempt::run ()
 			{
 				request_pull (lock);
 			}
-			else
+			else if (!request_duplicate (lock))
 			{
-				condition.wait (lock);
+				condition.wait_for (lock, std::chrono::seconds (1));
 			}
 		}
 		// Flushing may resolve forks which can add more pulls
@@ -988,9 +1217,10 @@ void rai::bootstrap_attempt::run ()
 	stopped = true;
 	condition.notify_all ();
 	idle.clear ();
+	in_flight.clear ();
 }
 
-std::shared_ptr<rai::bootstrap_client> rai::bootstrap_attempt::connection (std::unique_lock<std::mutex> & lock_a)
+std::shared_ptr<rai::bootstrap_client> rai::bootstrap_attempt::connection (std::unique_lock<std::mutex> & lock_a, bool fastest_a)
 {
 	while (!stopped && idle.empty ())
 	{
@@ -999,8 +1229,30 @@ std::shared_ptr<rai::bootstrap_client> rai::bootstrap_attempt::connection (std::
 	std::shared_ptr<rai::bootstrap_client> result;
 	if (!idle.empty ())
 	{
-		result = idle.back ();
-		idle.pop_back ();
+		auto existing (fastest_a ? fastest_idle (rai::tcp_endpoint ()) : idle.end () - 1);
+		result = *existing;
+		idle.erase (existing);
+	}
+	return result;
+}
+
+// Idle connection whose peer has the best pull rate, excluding connections to exclude_a
+std::deque<std::shared_ptr<rai::bootstrap_client>>::iterator rai::bootstrap_attempt::fastest_idle (rai::tcp_endpoint const & exclude_a)
+{
+	assert (!mutex.try_lock ());
+	auto result (idle.end ());
+	double best (-1.0);
+	for (auto i (idle.begin ()), n (idle.end ()); i != n; ++i)
+	{
+		if ((*i)->endpoint != exclude_a)
+		{
+			auto rate (node->bootstrap_initiator.peer_scores.rate (rai::endpoint ((*i)->endpoint.address (), (*i)->endpoint.port ())));
+			if (rate > best)
+			{
+				best = rate;
+				result = i;
+			}
+		}
 	}
 	return result;
 }
@@ -1155,6 +1407,11 @@ void rai::bootstrap_attempt::populate_connections ()
 			auto peer (node->peers.bootstrap_peer ());
 			if (peer != rai::endpoint (boost::asio::ip::address_v6::any (), 0))
 			{
+				if (connections > 0 && node->bootstrap_initiator.peer_scores.unreliable (peer))
+				{
+					// Peers which failed most of their pulls in earlier attempts are only used if there's nobody else
+					continue;
+				}
 				auto client (std::make_shared<rai::bootstrap_client> (node, shared_from_this (), rai::tcp_endpoint (peer.address (), peer.port ())));
 				client->run ();
 				std::lock_guard<std::mutex> lock (mutex);
@@ -1234,6 +1491,13 @@ void rai::bootstrap_attempt::add_pull (rai::pull_info const & pull)
 	condition.notify_all ();
 }
 
+void rai::bootstrap_attempt::add_pull (std::vector<rai::pull_info> const & pulls_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	pulls.insert (pulls.end (), pulls_a.begin (), pulls_a.end ());
+	condition.notify_all ();
+}
+
 void rai::bootstrap_attempt::requeue_pull (rai::pull_info const & pull_a)
 {
 	auto pull (pull_a);
@@ -1269,6 +1533,64 @@ void rai::bootstrap_attempt::requeue_pull (rai::pull_info const & pull_a)
 	}
 }
 
+rai::bootstrap_peer_score::bootstrap_peer_score () :
+rate (0.0),
+blocks (0),
+pulls (0),
+failures (0),
+seconds (0.0),
+last_pull (std::chrono::steady_clock::now ())
+{
+}
+
+void rai::bootstrap_peer_scores::pull_finished (rai::endpoint const & endpoint_a, uint64_t blocks_a, double seconds_a, bool failed_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (scores.find (endpoint_a));
+	if (existing == scores.end ())
+	{
+		if (scores.size () >= max_peers)
+		{
+			// Forget the peer which pulled longest ago
+			auto oldest (std::min_element (scores.begin (), scores.end (), [](std::pair<rai::endpoint const, rai::bootstrap_peer_score> const & lhs, std::pair<rai::endpoint const, rai::bootstrap_peer_score> const & rhs) { return lhs.second.last_pull < rhs.second.last_pull; }));
+			scores.erase (oldest);
+		}
+		existing = scores.insert (std::make_pair (endpoint_a, rai::bootstrap_peer_score ())).first;
+	}
+	auto & score (existing->second);
+	auto sample (seconds_a > 0.0 ? blocks_a / seconds_a : 0.0);
+	score.rate = score.pulls == 0 ? sample : score.rate + rate_weight * (sample - score.rate);
+	score.blocks += blocks_a;
+	++score.pulls;
+	if (failed_a)
+	{
+		++score.failures;
+	}
+	score.seconds += seconds_a;
+	score.last_pull = std::chrono::steady_clock::now ();
+}
+
+double rai::bootstrap_peer_scores::rate (rai::endpoint const & endpoint_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (scores.find (endpoint_a));
+	return existing != scores.end () ? existing->second.rate : 0.0;
+}
+
+// Rates from single block pulls mostly measure latency so only failures mark a peer as unreliable
+bool rai::bootstrap_peer_scores::unreliable (rai::endpoint const & endpoint_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (scores.find (endpoint_a));
+	return existing != scores.end () && existing->second.pulls >= trusted_pulls && existing->second.failures * 2 > existing->second.pulls;
+}
+
+std::vector<std::pair<rai::endpoint, rai::bootstrap_peer_score>> rai::bootstrap_peer_scores::list ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return std::vector<std::pair<rai::endpoint, rai::bootstrap_peer_score>> (scores.begin (), scores.end ());
+}
+
 rai::bootstrap_initiator::bootstrap_initiator (rai::node & node_a) :
 node (node_a),
 stopped (false),
@@ -1732,19 +2054,16 @@ void rai::bulk_pull_server::set_current_end ()
 
 void rai::bulk_pull_server::send_next ()
 {
-	std::unique_ptr<rai::block> block (get_next ());
-	if (block != nullptr)
+	auto count (fill_batch ());
+	if (count != 0)
 	{
-		{
-			send_buffer.clear ();
-			rai::vectorstream stream (send_buffer);
-			rai::serialize_block (stream, *block);
-		}
 		auto this_l (shared_from_this ());
 		if (connection->node->config.logging.bulk_pull_logging ())
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending %1% blocks, %2% bytes") % count % send_buffer.size ());
 		}
+		blocks_sent += count;
+		bytes_sent += send_buffer.size ();
 		async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
@@ -1755,29 +2074,65 @@ void rai::bulk_pull_server::send_next ()
 	}
 }
 
-std::unique_ptr<rai::block> rai::bulk_pull_server::get_next ()
+namespace
 {
-	std::unique_ptr<rai::block> result;
+// Previous hash of a block in its serialized form, data_a points after the type byte
+rai::block_hash serialized_previous (rai::block_type type_a, uint8_t const * data_a)
+{
+	rai::block_hash result (0);
+	switch (type_a)
+	{
+		case rai::block_type::send:
+		case rai::block_type::receive:
+		case rai::block_type::change:
+			std::copy (data_a, data_a + sizeof (result), result.bytes.begin ());
+			break;
+		case rai::block_type::state:
+			// Account precedes previous
+			std::copy (data_a + sizeof (rai::account), data_a + sizeof (rai::account) + sizeof (result), result.bytes.begin ());
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+}
+
+/**
+ * Copy up to batch_max blocks in to send_buffer from a single read transaction.
+ * Blocks are stored in their wire format so they're copied without deserializing.
+ */
+size_t rai::bulk_pull_server::fill_batch ()
+{
+	send_buffer.clear ();
+	size_t result (0);
 	if (current != request->end)
 	{
 		rai::transaction transaction (connection->node->store.environment, nullptr, false);
-		result = connection->node->store.block_get (transaction, current);
-		if (result != nullptr)
+		while (current != request->end && result < batch_max)
 		{
-			auto previous (result->previous ());
-			if (!previous.is_zero ())
+			rai::block_type type;
+			auto value (connection->node->store.block_get_raw (transaction, current, type));
+			if (value.mv_size != 0)
 			{
-				current = previous;
+				auto data (reinterpret_cast<uint8_t const *> (value.mv_data));
+				send_buffer.insert (send_buffer.end (), data, data + value.mv_size - rai::block_sideband::size);
+				++result;
+				auto previous (serialized_previous (type, data + 1));
+				if (!previous.is_zero ())
+				{
+					current = previous;
+				}
+				else
+				{
+					current = request->end;
+				}
 			}
 			else
 			{
 				current = request->end;
 			}
 		}
-		else
-		{
-			current = request->end;
-		}
 	}
 	return result;
 }
@@ -1804,7 +2159,10 @@ void rai::bulk_pull_server::send_finished ()
 	auto this_l (shared_from_this ());
 	if (connection->node->config.logging.bulk_pull_logging ())
 	{
-		BOOST_LOG (connection->node->log) << "Bulk sending finished";
+		auto elapsed (std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - start_time).count ());
+		auto blocks_rate (elapsed > 0.0 ? blocks_sent / elapsed : 0.0);
+		auto bytes_rate (elapsed > 0.0 ? bytes_sent / elapsed : 0.0);
+		BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk sending finished, %1% blocks %2% bytes (%3% blocks/s, %4% bytes/s)") % blocks_sent % bytes_sent % blocks_rate % bytes_rate);
 	}
 	async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), 1), [this_l](boost::system::error_code const & ec, size_t size_a) {
 		this_l->no_block_sent (ec, size_a);
@@ -1829,7 +2187,10 @@ void rai::bulk_pull_server::no_block_sent (boost::system::error_code const & ec,
 
 rai::bulk_pull_server::bulk_pull_server (std::shared_ptr<rai::bootstrap_server> const & connection_a, std::unique_ptr<rai::bulk_pull> request_a) :
 connection (connection_a),
-request (std::move (request_a))
+request (std::move (request_a)),
+start_time (std::chrono::steady_clock::now ()),
+blocks_sent (0),
+bytes_sent (0)
 {
 	set_current_end ();
 }
@@ -2127,48 +2488,85 @@ void rai::bulk_push_server::received_block (boost::system::error_code const & ec
 
 rai::frontier_req_server::frontier_req_server (std::shared_ptr<rai::bootstrap_server> const & connection_a, std::unique_ptr<rai::frontier_req> request_a) :
 connection (connection_a),
-current (request_a->start.number () - 1),
+current (0),
 info (0, 0, 0, 0, 0, 0),
-request (std::move (request_a))
+request (std::move (request_a)),
+count (0)
 {
-	next ();
-	skip_old ();
+	rai::transaction transaction (connection->node->store.environment, nullptr, false);
+	auto i (connection->node->store.latest_begin (transaction, request->start));
+	seek (i);
 }
 
-void rai::frontier_req_server::skip_old ()
+// Moves to the first account from i_a on which was modified recently enough to send
+void rai::frontier_req_server::seek (rai::store_iterator & i_a)
 {
-	if (request->age != std::numeric_limits<decltype (request->age)>::max ())
+	auto all (request->age == std::numeric_limits<decltype (request->age)>::max ());
+	auto now (rai::seconds_since_epoch ());
+	auto found (false);
+	for (auto n (connection->node->store.latest_end ()); !found && i_a != n;)
 	{
-		auto now (rai::seconds_since_epoch ());
-		while (!current.is_zero () && (now - info.modified) >= request->age)
+		rai::account_info info_l (i_a->second);
+		if (all || (now - info_l.modified) < request->age)
+		{
+			found = true;
+			current = rai::account (i_a->first.uint256 ());
+			info = info_l;
+		}
+		else
 		{
-			next ();
+			++i_a;
 		}
 	}
+	if (!found)
+	{
+		current.clear ();
+	}
 }
 
-void rai::frontier_req_server::send_next ()
+// Packs frontiers from current on into send_buffer using a single cursor, returns the number packed
+// At least one is packed unless there are none left, seeking past old accounts isn't bounded by batch_time
+size_t rai::frontier_req_server::fill_batch ()
 {
+	send_buffer.clear ();
+	size_t result (0);
 	if (!current.is_zero ())
 	{
+		auto cutoff (std::chrono::steady_clock::now () + batch_time);
+		rai::transaction transaction (connection->node->store.environment, nullptr, false);
+		// Accounts may have changed since the last batch's transaction so current is looked up again
+		auto i (connection->node->store.latest_begin (transaction, current));
+		seek (i);
+		while (!current.is_zero () && result < batch_max && (result == 0 || std::chrono::steady_clock::now () < cutoff))
 		{
-			send_buffer.clear ();
-			rai::vectorstream stream (send_buffer);
-			write (stream, current.bytes);
-			write (stream, info.head.bytes);
+			send_buffer.insert (send_buffer.end (), current.bytes.begin (), current.bytes.end ());
+			send_buffer.insert (send_buffer.end (), info.head.bytes.begin (), info.head.bytes.end ());
+			++result;
+			++i;
+			seek (i);
 		}
+	}
+	return result;
+}
+
+void rai::frontier_req_server::send_next ()
+{
+	auto sent (fill_batch ());
+	if (sent != 0)
+	{
+		count += sent;
 		auto this_l (shared_from_this ());
 		if (connection->node->config.logging.bulk_pull_logging ())
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending frontier for %1% %2%") % current.to_account () % info.head.to_string ());
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending %1% frontiers, %2% bytes") % sent % send_buffer.size ());
 		}
-		next ();
 		async_write (*connection->socket, boost::asio::buffer (send_buffer.data (), send_buffer.size ()), [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
 	}
 	else
 	{
+		assert (current.is_zero ());
 		send_finished ();
 	}
 }
@@ -2221,18 +2619,3 @@ void rai::frontier_req_server::sent_action (boost::system::error_code const & ec
 		}
 	}
 }
-
-void rai::frontier_req_server::next ()
-{
-	rai::transaction transaction (connection->node->store.environment, nullptr, false);
-	auto iterator (connection->node->store.latest_begin (transaction, current.number () + 1));
-	if (iterator != connection->node->store.latest_end ())
-	{
-		current = rai::uint256_union (iterator->first.uint256 ());
-		info = rai::account_info (iterator->second);
-	}
-	else
-	{
-		current.clear ();
-	}
-}
@@ -69,6 +69,7 @@ public:
 	unsigned attempts;
 };
 class frontier_req_client;
+class bulk_pull_client;
 class bulk_push_client;
 class bootstrap_attempt : public std::enable_shared_from_this<bootstrap_attempt>
 {
@@ -76,17 +77,21 @@ public:
 	bootstrap_attempt (std::shared_ptr<rai::node> node_a);
 	~bootstrap_attempt ();
 	void run ();
-	std::shared_ptr<rai::bootstrap_client> connection (std::unique_lock<std::mutex> &);
+	std::shared_ptr<rai::bootstrap_client> connection (std::unique_lock<std::mutex> &, bool = false);
+	std::deque<std::shared_ptr<rai::bootstrap_client>>::iterator fastest_idle (rai::tcp_endpoint const &);
 	bool consume_future (std::future<bool> &);
 	void populate_connections ();
 	bool request_frontier (std::unique_lock<std::mutex> &);
 	void request_pull (std::unique_lock<std::mutex> &);
 	bool request_push (std::unique_lock<std::mutex> &);
+	bool request_duplicate (std::unique_lock<std::mutex> &);
+	void add_in_flight (std::shared_ptr<rai::bulk_pull_client>);
 	void add_connection (rai::endpoint const &);
 	void pool_connection (std::shared_ptr<rai::bootstrap_client>);
 	void stop ();
 	void requeue_pull (rai::pull_info const &);
 	void add_pull (rai::pull_info const &);
+	void add_pull (std::vector<rai::pull_info> const &);
 	bool still_pulling ();
 	void process_fork (MDB_txn *, std::shared_ptr<rai::block>);
 	unsigned target_connections (size_t pulls_remaining);
@@ -98,6 +103,8 @@ public:
 	std::weak_ptr<rai::bulk_push_client> push;
 	std::deque<rai::pull_info> pulls;
 	std::deque<std::shared_ptr<rai::bootstrap_client>> idle;
+	// Running bulk pulls, candidates for a speculative duplicate once no pulls are left
+	std::vector<std::weak_ptr<rai::bulk_pull_client>> in_flight;
 	std::atomic<unsigned> connections;
 	std::atomic<unsigned> pulling;
 	std::shared_ptr<rai::node> node;
@@ -115,18 +122,28 @@ public:
 	void run ();
 	void receive_frontier ();
 	void received_frontier (boost::system::error_code const &, size_t);
+	bool compare_frontiers (std::vector<rai::pull_info> &);
+	void unsynced (rai::block_hash const &, rai::block_hash const &);
+	void flush_unsynced ();
 	void request_account (rai::account const &, rai::block_hash const &);
-	void unsynced (MDB_txn *, rai::account const &, rai::block_hash const &);
-	void next (MDB_txn *);
 	void insert_pull (rai::pull_info const &);
 	std::shared_ptr<rai::bootstrap_client> connection;
+	// Next local account to compare against, zero once every local account has been passed
 	rai::account current;
-	rai::account_info info;
 	unsigned count;
 	rai::account landing;
 	rai::account faucet;
 	std::chrono::steady_clock::time_point start_time;
 	std::promise<bool> promise;
+	// Bytes read from the peer which haven't been compared yet, a partial frontier is kept at the front
+	std::vector<uint8_t> receive_buffer;
+	size_t receive_size;
+	// Wallet account heads and the hash to walk back to, written as unsynced in batches
+	std::vector<std::pair<rai::block_hash, rai::block_hash>> unsynced_heads;
+	// Amount read from the socket at a time
+	static size_t constexpr receive_chunk = 64 * 1024;
+	// Queued unsynced walks which trigger a write transaction
+	static size_t constexpr unsynced_max = 256;
 };
 class bulk_pull_client : public std::enable_shared_from_this<rai::bulk_pull_client>
 {
@@ -135,12 +152,29 @@ public:
 	~bulk_pull_client ();
 	void request ();
 	void receive_block ();
-	void received_type ();
-	void received_block (boost::system::error_code const &, size_t);
+	void received_data (boost::system::error_code const &, size_t);
+	bool decode_blocks (std::vector<std::shared_ptr<rai::block>> &);
 	rai::block_hash first ();
+	void score (bool);
 	std::shared_ptr<rai::bootstrap_client> connection;
 	rai::block_hash expected;
 	rai::pull_info pull;
+	// Pulls requested on this connection after the current one, guarded by the attempt mutex like pull and pull_start
+	std::deque<rai::pull_info> batch;
+	std::chrono::steady_clock::time_point pull_start;
+	uint64_t pull_blocks;
+	// Racing the pull of another client which is taking too long, never requeued
+	bool speculative;
+	std::weak_ptr<rai::bulk_pull_client> original;
+	bool duplicated;
+	// Set when a speculative duplicate completed the pull first
+	std::atomic<bool> superseded;
+	// Bytes read from the peer which haven't been decoded yet, partial blocks are kept at the front
+	std::vector<uint8_t> receive_buffer;
+	size_t receive_size;
+	bool finished;
+	// Amount read from the socket at a time
+	static size_t constexpr receive_chunk = 64 * 1024;
 };
 class bootstrap_client : public std::enable_shared_from_this<bootstrap_client>
 {
@@ -178,6 +212,35 @@ public:
 	rai::push_synchronization synchronization;
 	std::promise<bool> promise;
 };
+class bootstrap_peer_score
+{
+public:
+	bootstrap_peer_score ();
+	// Exponentially weighted blocks per second over the peer's pulls
+	double rate;
+	uint64_t blocks;
+	uint64_t pulls;
+	uint64_t failures;
+	double seconds;
+	std::chrono::steady_clock::time_point last_pull;
+};
+// Bulk pull throughput of each peer, kept across bootstrap attempts
+class bootstrap_peer_scores
+{
+public:
+	void pull_finished (rai::endpoint const &, uint64_t, double, bool);
+	// Blocks per second, 0 if the peer hasn't served a pull yet
+	double rate (rai::endpoint const &);
+	bool unreliable (rai::endpoint const &);
+	std::vector<std::pair<rai::endpoint, rai::bootstrap_peer_score>> list ();
+	std::mutex mutex;
+	std::unordered_map<rai::endpoint, rai::bootstrap_peer_score> scores;
+	// Weight of the latest pull in the rate
+	static double constexpr rate_weight = 0.25;
+	// Pulls before a peer's failures are trusted enough to skip it
+	static uint64_t constexpr trusted_pulls = 8;
+	static size_t constexpr max_peers = 4096;
+};
 class bootstrap_initiator
 {
 public:
@@ -192,6 +255,7 @@ public:
 	std::shared_ptr<rai::bootstrap_attempt> current_attempt ();
 	void process_fork (MDB_txn *, std::shared_ptr<rai::block>);
 	void stop ();
+	rai::bootstrap_peer_scores peer_scores;
 
 private:
 	rai::node & node;
@@ -247,7 +311,7 @@ class bulk_pull_server : public std::enable_shared_from_this<rai::bulk_pull_serv
 public:
 	bulk_pull_server (std::shared_ptr<rai::bootstrap_server> const &, std::unique_ptr<rai::bulk_pull>);
 	void set_current_end ();
-	std::unique_ptr<rai::block> get_next ();
+	size_t fill_batch ();
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
 	void send_finished ();
@@ -256,6 +320,11 @@ public:
 	std::unique_ptr<rai::bulk_pull> request;
 	std::vector<uint8_t> send_buffer;
 	rai::block_hash current;
+	std::chrono::steady_clock::time_point start_time;
+	uint64_t blocks_sent;
+	uint64_t bytes_sent;
+	// Maximum blocks read in one transaction and sent in one write
+	static size_t constexpr batch_max = 256;
 };
 class bulk_pull_blocks;
 class bulk_pull_blocks_server : public std::enable_shared_from_this<rai::bulk_pull_blocks_server>
@@ -292,17 +361,21 @@ class frontier_req_server : public std::enable_shared_from_this<rai::frontier_re
 {
 public:
 	frontier_req_server (std::shared_ptr<rai::bootstrap_server> const &, std::unique_ptr<rai::frontier_req>);
-	void skip_old ();
+	void seek (rai::store_iterator &);
+	size_t fill_batch ();
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
 	void send_finished ();
 	void no_block_sent (boost::system::error_code const &, size_t);
-	void next ();
 	std::shared_ptr<rai::bootstrap_server> connection;
+	// Next account to send and its info, zero once the last frontier was sent
 	rai::account current;
 	rai::account_info info;
 	std::unique_ptr<rai::frontier_req> request;
 	std::vector<uint8_t> send_buffer;
 	size_t count;
+	// Most frontiers read in one transaction and sent in one write, and the longest the transaction is held
+	static size_t constexpr batch_max = 4096;
+	static std::chrono::milliseconds constexpr batch_time = std::chrono::milliseconds (100);
 };
 }
@@ -5,6 +5,7 @@
 #include <banano/node/rpc.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <future>
 #include <memory>
 #include <sstream>
@@ -23,6 +24,7 @@
 
 #include <ed25519-donna/ed25519.h>
 
+size_t constexpr rai::node::publish_filter_size;
 double constexpr rai::node::price_max;
 double constexpr rai::node::free_cutoff;
 std::chrono::seconds constexpr rai::node::period;
@@ -31,15 +33,125 @@ std::chrono::minutes constexpr rai::node::backup_interval;
 int constexpr rai::port_mapping::mapping_timeout;
 int constexpr rai::port_mapping::check_timeout;
 unsigned constexpr rai::active_transactions::announce_interval_ms;
+std::chrono::milliseconds constexpr rai::active_transactions::broadcast_interval;
+size_t constexpr rai::signature_checker::batch_size;
+size_t constexpr rai::block_processor::verification_max;
+size_t constexpr rai::block_processor::queue_max;
+size_t constexpr rai::block_processor::origins;
+size_t constexpr rai::block_processor::wait_buckets;
+size_t constexpr rai::vote_processor::tier_1_size;
+size_t constexpr rai::vote_processor::tier_2_size;
+size_t constexpr rai::vote_processor::max_size;
+size_t constexpr rai::vote_processor::batch_max;
+size_t constexpr rai::vote_signature_cache::max;
+std::chrono::seconds constexpr rai::vote_signature_cache::freshness;
+size_t constexpr rai::network::buffer_size;
+size_t constexpr rai::network::buffer_count;
+size_t constexpr rai::network::batch_max;
 
 rai::message_statistics::message_statistics () :
 keepalive (0),
 publish (0),
 confirm_req (0),
-confirm_ack (0)
+confirm_ack (0),
+packets (0),
+dropped (0),
+batches (0),
+batch_packets (0)
 {
 }
 
+rai::udp_buffer::udp_buffer (rai::message_statistics & stats_a, size_t size_a, size_t count_a) :
+stats (stats_a),
+free (count_a),
+full (count_a),
+slab (size_a * count_a),
+entries (count_a),
+stopped (false)
+{
+	assert (count_a > 0);
+	assert (size_a > 0);
+	auto slab_data (slab.data ());
+	auto entry_data (entries.data ());
+	for (size_t i (0); i < count_a; ++i, ++entry_data)
+	{
+		*entry_data = { slab_data + i * size_a, 0, rai::endpoint () };
+		free.push_back (entry_data);
+	}
+}
+
+rai::udp_data * rai::udp_buffer::allocate ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	rai::udp_data * result (nullptr);
+	if (!stopped)
+	{
+		if (!free.empty ())
+		{
+			result = free.front ();
+			free.pop_front ();
+		}
+		else if (!full.empty ())
+		{
+			// Processing is falling behind, drop the oldest datagram that hasn't been parsed yet
+			result = full.front ();
+			full.pop_front ();
+			++stats.dropped;
+		}
+	}
+	return result;
+}
+
+void rai::udp_buffer::enqueue (rai::udp_data * data_a)
+{
+	assert (data_a != nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		full.push_back (data_a);
+	}
+	++stats.packets;
+	condition.notify_one ();
+}
+
+bool rai::udp_buffer::dequeue (std::vector<rai::udp_data *> & data_a, size_t max_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped && full.empty ())
+	{
+		condition.wait (lock);
+	}
+	auto result (!stopped);
+	if (result)
+	{
+		while (!full.empty () && data_a.size () < max_a)
+		{
+			data_a.push_back (full.front ());
+			full.pop_front ();
+		}
+		++stats.batches;
+		stats.batch_packets += data_a.size ();
+	}
+	return result;
+}
+
+void rai::udp_buffer::release (rai::udp_data * data_a)
+{
+	assert (data_a != nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		free.push_back (data_a);
+	}
+}
+
+void rai::udp_buffer::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+}
+
 rai::network::network (rai::node & node_a, uint16_t port) :
 socket (node_a.service, rai::endpoint (boost::asio::ip::address_v6::any (), port)),
 resolver (node_a.service),
@@ -47,8 +159,27 @@ node (node_a),
 bad_sender_count (0),
 on (true),
 insufficient_work_count (0),
-error_count (0)
+error_count (0),
+buffer_container (incoming, buffer_size, buffer_count)
 {
+	for (auto i (0u), n (std::max<unsigned> (1, node_a.config.network_threads)); i < n; ++i)
+	{
+		packet_processing_threads.push_back (std::thread ([this]() { process_packets (); }));
+	}
+}
+
+rai::network::~network ()
+{
+	stop ();
+}
+
+void rai::network::start ()
+{
+	// Keep several receives outstanding so the io threads can fill buffers concurrently
+	for (auto i (0u), n (std::max<unsigned> (1, node.config.io_threads)); i < n; ++i)
+	{
+		receive ();
+	}
 }
 
 void rai::network::receive ()
@@ -57,17 +188,72 @@ void rai::network::receive ()
 	{
 		BOOST_LOG (node.log) << "Receiving packet";
 	}
-	std::unique_lock<std::mutex> lock (socket_mutex);
-	socket.async_receive_from (boost::asio::buffer (buffer.data (), buffer.size ()), remote, [this](boost::system::error_code const & error, size_t size_a) {
-		receive_action (error, size_a);
-	});
+	auto data (buffer_container.allocate ());
+	if (data != nullptr)
+	{
+		std::unique_lock<std::mutex> lock (socket_mutex);
+		socket.async_receive_from (boost::asio::buffer (data->buffer, buffer_size), data->endpoint, [this, data](boost::system::error_code const & error, size_t size_a) {
+			if (!error && on)
+			{
+				data->size = size_a;
+				buffer_container.enqueue (data);
+				receive ();
+			}
+			else
+			{
+				buffer_container.release (data);
+				if (error)
+				{
+					if (node.config.logging.network_logging ())
+					{
+						BOOST_LOG (node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+					}
+				}
+				if (on)
+				{
+					node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { receive (); });
+				}
+			}
+		});
+	}
+	else if (on)
+	{
+		// Every buffer is in flight, try again once processing threads have released some
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (5), [this]() { receive (); });
+	}
+}
+
+void rai::network::process_packets ()
+{
+	std::vector<rai::udp_data *> batch;
+	batch.reserve (batch_max);
+	while (buffer_container.dequeue (batch, batch_max))
+	{
+		for (auto data : batch)
+		{
+			receive_action (data);
+			buffer_container.release (data);
+		}
+		batch.clear ();
+	}
 }
 
 void rai::network::stop ()
 {
 	on = false;
-	socket.close ();
+	{
+		std::lock_guard<std::mutex> lock (socket_mutex);
+		socket.close ();
+	}
 	resolver.cancel ();
+	buffer_container.stop ();
+	for (auto & i : packet_processing_threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
 }
 
 void rai::network::send_keepalive (rai::endpoint const & endpoint_a)
@@ -163,13 +349,9 @@ bool confirm_block (MDB_txn * transaction_a, rai::node & node_a, T & list_a, std
 	{
 		node_a.wallets.foreach_representative (transaction_a, [&result, &block_a, &list_a, &node_a, &transaction_a](rai::public_key const & pub_a, rai::raw_key const & prv_a) {
 			result = true;
-			auto vote (node_a.store.vote_generate (transaction_a, pub_a, prv_a, block_a));
-			rai::confirm_ack confirm (vote);
-			std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-			{
-				rai::vectorstream stream (*bytes);
-				confirm.serialize (stream);
-			}
+			auto vote (node_a.vote_signatures.generate (transaction_a, pub_a, prv_a, block_a));
+			rai::confirm_ack confirm (vote.first);
+			auto & bytes (vote.second);
 			for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
 			{
 				node_a.network.confirm_send (confirm, bytes, *j);
@@ -357,7 +539,7 @@ public:
 		++node.network.incoming.publish;
 		node.peers.contacted (sender, message_a.version_using);
 		node.peers.insert (sender, message_a.version_using);
-		node.process_active (message_a.block);
+		process_active (message_a.block);
 	}
 	void confirm_req (rai::confirm_req const & message_a) override
 	{
@@ -368,7 +550,7 @@ public:
 		++node.network.incoming.confirm_req;
 		node.peers.contacted (sender, message_a.version_using);
 		node.peers.insert (sender, message_a.version_using);
-		node.process_active (message_a.block);
+		process_active (message_a.block);
 		rai::transaction transaction_a (node.store.environment, nullptr, false);
 		auto successor (node.ledger.successor (transaction_a, message_a.block->root ()));
 		if (successor != nullptr)
@@ -385,22 +567,19 @@ public:
 		++node.network.incoming.confirm_ack;
 		node.peers.contacted (sender, message_a.version_using);
 		node.peers.insert (sender, message_a.version_using);
-		node.process_active (message_a.vote->block);
-		auto vote (node.vote_processor.vote (message_a.vote, sender));
-		if (vote.code == rai::vote_code::replay)
-		{
-			// This tries to assist rep nodes that have lost track of their highest sequence number by replaying our highest known vote back to them
-			// Only do this if the sequence number is significantly different to account for network reordering
-			// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
-			if (vote.vote->sequence > message_a.vote->sequence + 10000)
+		process_active (message_a.vote->block);
+		node.vote_processor.add (message_a.vote, sender);
+	}
+	// Rebroadcasts of a block we've just seen are dropped before they reach the block processor
+	void process_active (std::shared_ptr<rai::block> const & block_a)
+	{
+		auto digest (block_a->full_hash ());
+		if (!node.publish_filter.apply (digest))
+		{
+			if (node.process_active (block_a))
 			{
-				rai::confirm_ack confirm (vote.vote);
-				std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-				{
-					rai::vectorstream stream (*bytes);
-					confirm.serialize (stream);
-				}
-				node.network.confirm_send (confirm, bytes, sender);
+				// The block never made it into the queue, a later rebroadcast has to get through
+				node.publish_filter.clear (digest);
 			}
 		}
 	}
@@ -425,15 +604,15 @@ public:
 };
 }
 
-void rai::network::receive_action (boost::system::error_code const & error, size_t size_a)
+void rai::network::receive_action (rai::udp_data * data_a)
 {
-	if (!error && on)
+	if (on)
 	{
-		if (!rai::reserved_address (remote) && remote != endpoint ())
+		if (!rai::reserved_address (data_a->endpoint) && data_a->endpoint != endpoint ())
 		{
-			network_message_visitor visitor (node, remote);
+			network_message_visitor visitor (node, data_a->endpoint);
 			rai::message_parser parser (visitor, node.work);
-			parser.deserialize_buffer (buffer.data (), size_a);
+			parser.deserialize_buffer (data_a->buffer, data_a->size);
 			if (parser.status != rai::message_parser::parse_status::success)
 			{
 				++error_count;
@@ -499,25 +678,10 @@ void rai::network::receive_action (boost::system::error_code const & error, size
 		{
 			if (node.config.logging.network_logging ())
 			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % remote.address ().to_string ());
+				BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data_a->endpoint.address ().to_string ());
 			}
 			++bad_sender_count;
 		}
-		receive ();
-	}
-	else
-	{
-		if (error)
-		{
-			if (node.config.logging.network_logging ())
-			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
-			}
-		}
-		if (on)
-		{
-			node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { receive (); });
-		}
 	}
 }
 
@@ -820,7 +984,15 @@ bootstrap_connections_max (64),
 callback_port (0),
 lmdb_max_dbs (128),
 state_block_parse_canary (0),
-state_block_generate_canary (0)
+state_block_generate_canary (0),
+signature_checker_threads (std::thread::hardware_concurrency () / 2),
+network_threads (std::max<unsigned> (4, std::thread::hardware_concurrency ())),
+block_processor_batch_max_blocks (16384),
+block_processor_batch_max_time (rai::transaction_timeout),
+lmdb_sync_interval (0),
+election_announce_budget (256),
+election_broadcast_batch (32),
+vote_processor_threads (std::max<unsigned> (1, std::thread::hardware_concurrency () / 4))
 {
 	switch (rai::banano_network)
 	{
@@ -854,7 +1026,7 @@ state_block_generate_canary (0)
 
 void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "10");
+	tree_a.put ("version", "15");
 	tree_a.put ("peering_port", std::to_string (peering_port));
 	tree_a.put ("bootstrap_fraction_numerator", std::to_string (bootstrap_fraction_numerator));
 	tree_a.put ("receive_minimum", receive_minimum.to_string_dec ());
@@ -898,6 +1070,14 @@ void rai::node_config::serialize_json (boost::property_tree::ptree & tree_a) con
 	tree_a.put ("lmdb_max_dbs", lmdb_max_dbs);
 	tree_a.put ("state_block_parse_canary", state_block_parse_canary.to_string ());
 	tree_a.put ("state_block_generate_canary", state_block_generate_canary.to_string ());
+	tree_a.put ("signature_checker_threads", std::to_string (signature_checker_threads));
+	tree_a.put ("network_threads", std::to_string (network_threads));
+	tree_a.put ("block_processor_batch_max_blocks", std::to_string (block_processor_batch_max_blocks));
+	tree_a.put ("block_processor_batch_max_time", std::to_string (block_processor_batch_max_time.count ()));
+	tree_a.put ("lmdb_sync_interval", std::to_string (lmdb_sync_interval.count ()));
+	tree_a.put ("election_announce_budget", std::to_string (election_announce_budget));
+	tree_a.put ("election_broadcast_batch", std::to_string (election_broadcast_batch));
+	tree_a.put ("vote_processor_threads", std::to_string (vote_processor_threads));
 }
 
 bool rai::node_config::upgrade_json (unsigned version, boost::property_tree::ptree & tree_a)
@@ -978,6 +1158,34 @@ bool rai::node_config::upgrade_json (unsigned version, boost::property_tree::ptr
 			tree_a.put ("version", "10");
 			result = true;
 		case 10:
+			tree_a.put ("signature_checker_threads", std::to_string (signature_checker_threads));
+			tree_a.erase ("version");
+			tree_a.put ("version", "11");
+			result = true;
+		case 11:
+			tree_a.put ("network_threads", std::to_string (network_threads));
+			tree_a.erase ("version");
+			tree_a.put ("version", "12");
+			result = true;
+		case 12:
+			tree_a.put ("block_processor_batch_max_blocks", std::to_string (block_processor_batch_max_blocks));
+			tree_a.put ("block_processor_batch_max_time", std::to_string (block_processor_batch_max_time.count ()));
+			tree_a.put ("lmdb_sync_interval", std::to_string (lmdb_sync_interval.count ()));
+			tree_a.erase ("version");
+			tree_a.put ("version", "13");
+			result = true;
+		case 13:
+			tree_a.put ("election_announce_budget", std::to_string (election_announce_budget));
+			tree_a.put ("election_broadcast_batch", std::to_string (election_broadcast_batch));
+			tree_a.erase ("version");
+			tree_a.put ("version", "14");
+			result = true;
+		case 14:
+			tree_a.put ("vote_processor_threads", std::to_string (vote_processor_threads));
+			tree_a.erase ("version");
+			tree_a.put ("version", "15");
+			result = true;
+		case 15:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -1053,6 +1261,14 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 		result |= parse_port (callback_port_l, callback_port);
 		auto state_block_parse_canary_l = tree_a.get<std::string> ("state_block_parse_canary");
 		auto state_block_generate_canary_l = tree_a.get<std::string> ("state_block_generate_canary");
+		auto signature_checker_threads_l (tree_a.get<std::string> ("signature_checker_threads"));
+		auto network_threads_l (tree_a.get<std::string> ("network_threads"));
+		auto block_processor_batch_max_blocks_l (tree_a.get<std::string> ("block_processor_batch_max_blocks"));
+		auto block_processor_batch_max_time_l (tree_a.get<std::string> ("block_processor_batch_max_time"));
+		auto lmdb_sync_interval_l (tree_a.get<std::string> ("lmdb_sync_interval"));
+		auto election_announce_budget_l (tree_a.get<std::string> ("election_announce_budget"));
+		auto election_broadcast_batch_l (tree_a.get<std::string> ("election_broadcast_batch"));
+		auto vote_processor_threads_l (tree_a.get<std::string> ("vote_processor_threads"));
 		try
 		{
 			peering_port = std::stoul (peering_port_l);
@@ -1063,6 +1279,14 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 			bootstrap_connections = std::stoul (bootstrap_connections_l);
 			bootstrap_connections_max = std::stoul (bootstrap_connections_max_l);
 			lmdb_max_dbs = std::stoi (lmdb_max_dbs_l);
+			signature_checker_threads = std::stoul (signature_checker_threads_l);
+			network_threads = std::stoul (network_threads_l);
+			block_processor_batch_max_blocks = std::stoul (block_processor_batch_max_blocks_l);
+			block_processor_batch_max_time = std::chrono::milliseconds (std::stoul (block_processor_batch_max_time_l));
+			lmdb_sync_interval = std::chrono::milliseconds (std::stoul (lmdb_sync_interval_l));
+			election_announce_budget = std::stoul (election_announce_budget_l);
+			election_broadcast_batch = std::stoul (election_broadcast_batch_l);
+			vote_processor_threads = std::stoul (vote_processor_threads_l);
 			result |= peering_port > std::numeric_limits<uint16_t>::max ();
 			result |= logging.deserialize_json (upgraded_a, logging_l);
 			result |= receive_minimum.decode_dec (receive_minimum_l);
@@ -1070,6 +1294,11 @@ bool rai::node_config::deserialize_json (bool & upgraded_a, boost::property_tree
 			result |= password_fanout < 16;
 			result |= password_fanout > 1024 * 1024;
 			result |= io_threads == 0;
+			result |= network_threads == 0;
+			result |= block_processor_batch_max_blocks == 0;
+			result |= election_announce_budget == 0;
+			result |= election_broadcast_batch == 0;
+			result |= vote_processor_threads == 0;
 			result |= state_block_parse_canary.decode_hex (state_block_parse_canary_l);
 			result |= state_block_generate_canary.decode_hex (state_block_generate_canary_l);
 		}
@@ -1094,14 +1323,253 @@ rai::account rai::node_config::random_representative ()
 }
 
 rai::vote_processor::vote_processor (rai::node & node_a) :
-node (node_a)
+node (node_a),
+dropped (0),
+stopped (false),
+active (0),
+next_log (std::chrono::steady_clock::now ())
 {
+	seed_tiers ();
+	for (auto i (0u); i < node.config.vote_processor_threads; ++i)
+	{
+		threads.push_back (std::thread ([this]() { process_loop (); }));
+	}
 }
 
-rai::vote_result rai::vote_processor::vote (std::shared_ptr<rai::vote> vote_a, rai::endpoint endpoint_a)
+rai::vote_processor::~vote_processor ()
+{
+	stop ();
+}
+
+void rai::vote_processor::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
+}
+
+bool rai::vote_processor::add (std::shared_ptr<rai::vote> vote_a, rai::endpoint const & endpoint_a)
+{
+	auto result (false);
+	size_t size_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		size_l = votes.size ();
+		if (stopped)
+		{
+			result = true;
+		}
+		else if (size_l < tier_1_size)
+		{
+			result = false;
+		}
+		else if (size_l < tier_2_size)
+		{
+			// Shed votes from the least significant representatives first as the queue fills
+			result = representatives_1.find (vote_a->account) == representatives_1.end ();
+		}
+		else if (size_l < max_size)
+		{
+			result = representatives_2.find (vote_a->account) == representatives_2.end ();
+		}
+		else
+		{
+			result = true;
+		}
+		if (!result)
+		{
+			votes.push_back (std::make_pair (vote_a, endpoint_a));
+			condition.notify_all ();
+		}
+	}
+	if (result)
+	{
+		++dropped;
+	}
+	if (size_l >= tier_1_size && should_log ())
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("%1% votes in processing queue, %2% dropped") % size_l % dropped.load ());
+	}
+	return result;
+}
+
+void rai::vote_processor::flush ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped && (!votes.empty () || active > 0))
+	{
+		condition.wait (lock);
+	}
+}
+
+size_t rai::vote_processor::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return votes.size ();
+}
+
+bool rai::vote_processor::should_log ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto result (false);
+	auto now (std::chrono::steady_clock::now ());
+	if (next_log < now)
+	{
+		next_log = now + std::chrono::seconds (15);
+		result = true;
+	}
+	return result;
+}
+
+void rai::vote_processor::process_loop ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!votes.empty ())
+		{
+			auto count (std::min (votes.size (), batch_max));
+			std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> votes_l (votes.begin (), votes.begin () + count);
+			votes.erase (votes.begin (), votes.begin () + count);
+			++active;
+			lock.unlock ();
+			std::vector<int> verifications;
+			verify_votes (votes_l, verifications);
+			update_tiers (votes_l, verifications);
+			for (size_t i (0); i < count; ++i)
+			{
+				auto & vote_l (votes_l[i].first);
+				auto & endpoint_l (votes_l[i].second);
+				auto result (vote (vote_l, endpoint_l, verifications[i] == 1 ? rai::signature_verification::valid : rai::signature_verification::invalid));
+				if (result.code == rai::vote_code::replay)
+				{
+					// This tries to assist rep nodes that have lost track of their highest sequence number by replaying our highest known vote back to them
+					// Only do this if the sequence number is significantly different to account for network reordering
+					// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
+					if (result.vote->sequence > vote_l->sequence + 10000)
+					{
+						rai::confirm_ack confirm (result.vote);
+						std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
+						{
+							rai::vectorstream stream (*bytes);
+							confirm.serialize (stream);
+						}
+						node.network.confirm_send (confirm, bytes, endpoint_l);
+					}
+				}
+			}
+			lock.lock ();
+			--active;
+		}
+		else
+		{
+			condition.notify_all ();
+			condition.wait (lock);
+		}
+	}
+}
+
+void rai::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> & votes_a, std::vector<int> & verifications_a)
+{
+	auto size (votes_a.size ());
+	std::vector<rai::uint256_union> hashes;
+	std::vector<unsigned char const *> messages;
+	std::vector<size_t> lengths;
+	std::vector<unsigned char const *> pub_keys;
+	std::vector<unsigned char const *> signatures;
+	hashes.reserve (size);
+	messages.reserve (size);
+	lengths.reserve (size);
+	pub_keys.reserve (size);
+	signatures.reserve (size);
+	verifications_a.assign (size, 0);
+	for (auto & i : votes_a)
+	{
+		hashes.push_back (i.first->hash ());
+		messages.push_back (hashes.back ().bytes.data ());
+		lengths.push_back (sizeof (rai::uint256_union));
+		pub_keys.push_back (i.first->account.bytes.data ());
+		signatures.push_back (i.first->signature.bytes.data ());
+	}
+	rai::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signatures.data (), verifications_a.data () };
+	node.checker.verify (check);
+}
+
+// Sort representatives we hear from into weight tiers used to shed load when the queue fills
+void rai::vote_processor::update_tiers (std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> & votes_a, std::vector<int> & verifications_a)
+{
+	std::vector<std::pair<rai::account, rai::uint128_t>> weights;
+	weights.reserve (votes_a.size ());
+	for (size_t i (0), n (votes_a.size ()); i < n; ++i)
+	{
+		if (verifications_a[i] == 1)
+		{
+			auto & account (votes_a[i].first->account);
+			weights.push_back (std::make_pair (account, node.store.representation_cache.get (account)));
+		}
+	}
+	auto online_stake (node.online_reps.online_stake ());
+	std::lock_guard<std::mutex> lock (mutex);
+	for (auto & i : weights)
+	{
+		place (i.first, i.second, online_stake);
+	}
+}
+
+// Online stake isn't known until reps have been heard from, so start with tiers measured against all voting weight
+void rai::vote_processor::seed_tiers ()
+{
+	auto weights (node.store.representation_cache.list ());
+	rai::uint128_t total (0);
+	for (auto & i : weights)
+	{
+		total += i.second;
+	}
+	std::lock_guard<std::mutex> lock (mutex);
+	for (auto & i : weights)
+	{
+		place (i.first, i.second, total);
+	}
+}
+
+void rai::vote_processor::place (rai::account const & account_a, rai::uint128_t const & weight_a, rai::uint128_t const & stake_a)
+{
+	if (weight_a >= stake_a / 1000)
+	{
+		representatives_1.insert (account_a);
+	}
+	else
+	{
+		representatives_1.erase (account_a);
+	}
+	if (weight_a >= stake_a / 100)
+	{
+		representatives_2.insert (account_a);
+	}
+	else
+	{
+		representatives_2.erase (account_a);
+	}
+}
+
+rai::vote_result rai::vote_processor::vote (std::shared_ptr<rai::vote> vote_a, rai::endpoint endpoint_a, rai::signature_verification verification_a)
 {
 	rai::vote_result result = { rai::vote_code::invalid, vote_a };
-	if (!rai::validate_message (vote_a->account, vote_a->hash (), vote_a->signature))
+	auto valid (verification_a == rai::signature_verification::valid);
+	if (verification_a == rai::signature_verification::unknown)
+	{
+		valid = !rai::validate_message (vote_a->account, vote_a->hash (), vote_a->signature);
+	}
+	if (valid)
 	{
 		result.code = rai::vote_code::replay;
 		std::shared_ptr<rai::vote> newest_vote;
@@ -1164,12 +1632,119 @@ bool rai::rep_crawler::exists (rai::block_hash const & hash_a)
 	return active.count (hash_a) != 0;
 }
 
+rai::signature_checker::signature_checker (unsigned threads_a) :
+stopped (false)
+{
+	for (auto i (0u); i < threads_a; ++i)
+	{
+		threads.push_back (std::thread ([this]() { run (); }));
+	}
+}
+
+rai::signature_checker::~signature_checker ()
+{
+	stop ();
+}
+
+void rai::signature_checker::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		condition.notify_all ();
+	}
+	for (auto & i : threads)
+	{
+		if (i.joinable ())
+		{
+			i.join ();
+		}
+	}
+}
+
+void rai::signature_checker::verify (rai::signature_check_set & check_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	if (stopped || threads.empty () || check_a.size <= batch_size)
+	{
+		lock.unlock ();
+		verify_batch (check_a, 0, check_a.size);
+	}
+	else
+	{
+		auto chunks ((check_a.size + batch_size - 1) / batch_size);
+		std::atomic<size_t> pending (chunks - 1);
+		std::promise<void> promise;
+		auto future (promise.get_future ());
+		for (size_t i (1); i < chunks; ++i)
+		{
+			auto start (i * batch_size);
+			auto size (std::min (batch_size, check_a.size - start));
+			tasks.push_back ([this, &check_a, start, size, &pending, &promise]() {
+				verify_batch (check_a, start, size);
+				if (--pending == 0)
+				{
+					promise.set_value ();
+				}
+			});
+		}
+		condition.notify_all ();
+		lock.unlock ();
+		// The calling thread verifies the first chunk while the pool works on the rest
+		verify_batch (check_a, 0, batch_size);
+		future.wait ();
+	}
+}
+
+void rai::signature_checker::verify_batch (rai::signature_check_set & check_a, size_t start_a, size_t size_a)
+{
+	rai::validate_message_batch (check_a.messages + start_a, check_a.message_lengths + start_a, check_a.pub_keys + start_a, check_a.signatures + start_a, size_a, check_a.verifications + start_a);
+}
+
+void rai::signature_checker::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	// Drain queued tasks on stop so no caller of verify is left waiting
+	while (!stopped || !tasks.empty ())
+	{
+		if (!tasks.empty ())
+		{
+			auto task (tasks.front ());
+			tasks.pop_front ();
+			lock.unlock ();
+			task ();
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
 rai::block_processor::block_processor (rai::node & node_a) :
+batches (0),
+batch_size (0),
+batch_commit_us (0),
+batch_blocks_per_sec (0),
 stopped (false),
 active (false),
+next_queue (0),
+queue_credit (0),
 node (node_a),
 next_log (std::chrono::steady_clock::now ())
 {
+	for (auto & i : wait_times)
+	{
+		for (auto & j : i)
+		{
+			j = 0;
+		}
+	}
+	for (auto & i : dropped)
+	{
+		i = 0;
+	}
 }
 
 rai::block_processor::~block_processor ()
@@ -1187,24 +1762,77 @@ void rai::block_processor::stop ()
 void rai::block_processor::flush ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && (!blocks.empty () || active))
+	while (!stopped && (have_blocks () || active))
+	{
+		condition.wait (lock);
+	}
+}
+
+bool rai::block_processor::add (std::shared_ptr<rai::block> block_a, rai::block_origin origin_a)
+{
+	std::vector<std::shared_ptr<rai::block>> blocks_l (1, std::move (block_a));
+	return add (blocks_l, origin_a);
+}
+
+bool rai::block_processor::add (std::vector<std::shared_ptr<rai::block>> const & blocks_a, rai::block_origin origin_a, std::vector<std::shared_ptr<rai::block>> * dropped_a)
+{
+	auto now (std::chrono::steady_clock::now ());
+	size_t dropped_l (0);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto & queue (queues[static_cast<size_t> (origin_a)]);
+		for (auto & block : blocks_a)
+		{
+			if (queue.size () < queue_max)
+			{
+				if (origin_a == rai::block_origin::bootstrap)
+				{
+					// Pulls arrive newest first, taking the latest arrival first processes each chain from its oldest block
+					queue.push_front (rai::block_processor_item{ block, rai::signature_verification::unknown, now });
+				}
+				else
+				{
+					queue.push_back (rai::block_processor_item{ block, rai::signature_verification::unknown, now });
+				}
+			}
+			else
+			{
+				++dropped_l;
+				if (dropped_a != nullptr)
+				{
+					dropped_a->push_back (block);
+				}
+			}
+		}
+		condition.notify_all ();
+	}
+	if (dropped_l > 0)
 	{
-		condition.wait (lock);
+		dropped[static_cast<size_t> (origin_a)] += dropped_l;
+		if (node.config.logging.ledger_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("Block processor queue %1% is full, dropped %2% blocks") % static_cast<unsigned> (origin_a) % dropped_l);
+		}
 	}
+	return dropped_l > 0;
 }
 
-void rai::block_processor::add (std::shared_ptr<rai::block> block_a)
+void rai::block_processor::force (std::shared_ptr<rai::block> block_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
-	blocks.push_front (block_a);
+	forced.push_front (block_a);
 	condition.notify_all ();
 }
 
-void rai::block_processor::force (std::shared_ptr<rai::block> block_a)
+size_t rai::block_processor::queue_size (rai::block_origin origin_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
-	forced.push_front (block_a);
-	condition.notify_all ();
+	return queues[static_cast<size_t> (origin_a)].size ();
+}
+
+bool rai::block_processor::saturated (rai::block_origin origin_a)
+{
+	return queue_size (origin_a) >= queue_max / 2;
 }
 
 void rai::block_processor::process_blocks ()
@@ -1241,29 +1869,197 @@ bool rai::block_processor::should_log ()
 }
 
 bool rai::block_processor::have_blocks ()
+{
+	assert (!mutex.try_lock ());
+	auto result (have_verified ());
+	for (auto i (queues.begin ()), n (queues.end ()); !result && i != n; ++i)
+	{
+		result = !i->empty ();
+	}
+	return result;
+}
+
+bool rai::block_processor::have_verified ()
 {
 	assert (!mutex.try_lock ());
 	return !blocks.empty () || !forced.empty ();
 }
 
+namespace
+{
+// Blocks taken from an origin's queue before moving on to the next one
+unsigned queue_weight (size_t origin_a)
+{
+	unsigned result (1);
+	switch (static_cast<rai::block_origin> (origin_a))
+	{
+		case rai::block_origin::live:
+		case rai::block_origin::local:
+			result = 8;
+			break;
+		case rai::block_origin::unchecked:
+			result = 4;
+			break;
+		case rai::block_origin::bootstrap:
+			result = 1;
+			break;
+	}
+	return result;
+}
+}
+
+void rai::block_processor::select_blocks (std::vector<rai::block_processor_item> & items_a, size_t max_a)
+{
+	assert (!mutex.try_lock ());
+	auto now (std::chrono::steady_clock::now ());
+	size_t remaining (0);
+	for (auto & i : queues)
+	{
+		remaining += i.size ();
+	}
+	while (remaining > 0 && items_a.size () < max_a)
+	{
+		auto & queue (queues[next_queue]);
+		if (queue.empty () || queue_credit == 0)
+		{
+			next_queue = (next_queue + 1) % queues.size ();
+			queue_credit = queue_weight (next_queue);
+		}
+		else
+		{
+			auto waited (std::chrono::duration_cast<std::chrono::milliseconds> (now - queue.front ().arrival).count ());
+			size_t bucket (0);
+			while (bucket + 1 < wait_buckets && waited >= (1 << bucket))
+			{
+				++bucket;
+			}
+			++wait_times[next_queue][bucket];
+			items_a.push_back (std::move (queue.front ()));
+			queue.pop_front ();
+			--queue_credit;
+			--remaining;
+		}
+	}
+}
+
+void rai::block_processor::verify_state_blocks (std::vector<rai::block_processor_item> & items_a)
+{
+	// State and open blocks name their signing account and can be verified in batches before reaching the ledger
+	std::vector<rai::block_processor_item *> items;
+	for (auto & i : items_a)
+	{
+		auto type (i.block->type ());
+		if (i.verification == rai::signature_verification::unknown && (type == rai::block_type::state || type == rai::block_type::open))
+		{
+			items.push_back (&i);
+		}
+	}
+	for (size_t offset (0); offset < items.size (); offset += verification_max)
+	{
+		auto count (std::min (items.size () - offset, verification_max));
+		std::vector<rai::block_hash> hashes;
+		std::vector<rai::signature> signatures;
+		std::vector<unsigned char const *> messages;
+		std::vector<size_t> lengths;
+		std::vector<unsigned char const *> pub_keys;
+		std::vector<unsigned char const *> signature_pointers;
+		std::vector<int> verifications (count, 0);
+		hashes.reserve (count);
+		signatures.reserve (count);
+		messages.reserve (count);
+		lengths.reserve (count);
+		pub_keys.reserve (count);
+		signature_pointers.reserve (count);
+		for (auto i (offset), n (offset + count); i != n; ++i)
+		{
+			auto & block (*items[i]->block);
+			hashes.push_back (block.hash ());
+			signatures.push_back (block.block_signature ());
+			messages.push_back (hashes.back ().bytes.data ());
+			lengths.push_back (sizeof (rai::block_hash));
+			if (block.type () == rai::block_type::state)
+			{
+				pub_keys.push_back (static_cast<rai::state_block const &> (block).hashables.account.bytes.data ());
+			}
+			else
+			{
+				pub_keys.push_back (static_cast<rai::open_block const &> (block).hashables.account.bytes.data ());
+			}
+			signature_pointers.push_back (signatures.back ().bytes.data ());
+		}
+		rai::signature_check_set check = { count, messages.data (), lengths.data (), pub_keys.data (), signature_pointers.data (), verifications.data () };
+		node.checker.verify (check);
+		for (size_t i (0); i < count; ++i)
+		{
+			items[offset + i]->verification = verifications[i] == 1 ? rai::signature_verification::valid : rai::signature_verification::invalid;
+			if (verifications[i] != 1 && node.config.logging.ledger_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Bad signature for: %1%") % hashes[i].to_string ());
+			}
+		}
+	}
+}
+
+void rai::block_processor::log_queues ()
+{
+	assert (!mutex.try_lock ());
+	static std::array<char const *, origins> const names = { { "live", "bootstrap", "unchecked", "local" } };
+	BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks in processing queue, %2% live, %3% bootstrap, %4% unchecked, %5% local") % blocks.size () % queues[0].size () % queues[1].size () % queues[2].size () % queues[3].size ());
+	for (size_t i (0); i < origins; ++i)
+	{
+		std::string histogram;
+		for (size_t j (0); j < wait_buckets; ++j)
+		{
+			histogram += boost::str (boost::format (" %1%") % wait_times[i][j].load ());
+		}
+		BOOST_LOG (node.log) << boost::str (boost::format ("%1% queue wait times by power of two milliseconds:%2%") % names[i] % histogram);
+	}
+}
+
 void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> & lock_a)
 {
-	std::deque<std::pair<std::shared_ptr<rai::block>, rai::process_return>> progress;
+	progress.clear ();
+	lock_a.lock ();
+	if (blocks.empty ())
+	{
+		selected.clear ();
+		select_blocks (selected, node.config.block_processor_batch_max_blocks);
+		if (!selected.empty ())
+		{
+			// Signatures are checked outside of the write transaction
+			lock_a.unlock ();
+			verify_state_blocks (selected);
+			lock_a.lock ();
+			for (auto & i : selected)
+			{
+				if (i.verification != rai::signature_verification::invalid)
+				{
+					blocks.push_back (std::make_pair (std::move (i.block), i.verification));
+				}
+			}
+		}
+	}
+	lock_a.unlock ();
+	auto start (std::chrono::steady_clock::now ());
+	std::chrono::steady_clock::time_point commit_start;
+	size_t count (0);
 	{
 		rai::transaction transaction (node.store.environment, nullptr, true);
-		auto cutoff (std::chrono::steady_clock::now () + rai::transaction_timeout);
+		auto cutoff (start + node.config.block_processor_batch_max_time);
 		lock_a.lock ();
-		while (have_blocks () && std::chrono::steady_clock::now () < cutoff)
+		while (have_verified () && std::chrono::steady_clock::now () < cutoff && count < node.config.block_processor_batch_max_blocks)
 		{
 			if (blocks.size () > 64 && should_log ())
 			{
-				BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks in processing queue") % blocks.size ());
+				log_queues ();
 			}
 			std::shared_ptr<rai::block> block;
+			auto verification (rai::signature_verification::unknown);
 			bool force (false);
 			if (forced.empty ())
 			{
-				block = blocks.front ();
+				block = blocks.front ().first;
+				verification = blocks.front ().second;
 				blocks.pop_front ();
 			}
 			else
@@ -1284,7 +2080,7 @@ void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> &
 					node.ledger.rollback (transaction, successor->hash ());
 				}
 			}
-			auto process_result (process_receive_one (transaction, block));
+			auto process_result (process_receive_one (transaction, block, verification));
 			switch (process_result.code)
 			{
 				case rai::process_result::progress:
@@ -1293,11 +2089,29 @@ void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> &
 				}
 				case rai::process_result::old:
 				{
-					auto cached (node.store.unchecked_get (transaction, hash));
-					for (auto i (cached.begin ()), n (cached.end ()); i != n; ++i)
+					auto released (node.store.unchecked_release (transaction, hash));
+					if (!released.empty ())
 					{
-						node.store.unchecked_del (transaction, hash, **i);
-						add (*i);
+						std::vector<std::shared_ptr<rai::block>> dependents;
+						dependents.reserve (released.size ());
+						for (auto & i : released)
+						{
+							dependents.push_back (i.second);
+						}
+						std::vector<std::shared_ptr<rai::block>> dropped_l;
+						if (add (dependents, rai::block_origin::unchecked, &dropped_l))
+						{
+							// Put back the blocks which didn't fit in the queue, they're retried when this block is seen again
+							auto j (dropped_l.begin ());
+							for (auto i (released.begin ()), n (released.end ()); i != n && j != dropped_l.end (); ++i)
+							{
+								if (i->second == *j)
+								{
+									node.store.unchecked_put (transaction, i->first, i->second);
+									++j;
+								}
+							}
+						}
 					}
 					std::lock_guard<std::mutex> lock (node.gap_cache.mutex);
 					node.gap_cache.blocks.get<1> ().erase (hash);
@@ -1306,10 +2120,22 @@ void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> &
 				default:
 					break;
 			}
+			++count;
 			lock_a.lock ();
 		}
+		lock_a.unlock ();
+		commit_start = std::chrono::steady_clock::now ();
+	}
+	auto end (std::chrono::steady_clock::now ());
+	auto elapsed_us (std::chrono::duration_cast<std::chrono::microseconds> (end - start).count ());
+	++batches;
+	batch_size = count;
+	batch_commit_us = std::chrono::duration_cast<std::chrono::microseconds> (end - commit_start).count ();
+	batch_blocks_per_sec = elapsed_us > 0 ? count * 1000000 / elapsed_us : 0;
+	if (count > 0 && should_log ())
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("Processed %1% blocks in %2% microseconds (%3% blocks/s), commit took %4% microseconds") % count % elapsed_us % batch_blocks_per_sec.load () % batch_commit_us.load ());
 	}
-	lock_a.unlock ();
 	for (auto & i : progress)
 	{
 		node.observers.blocks (i.first, i.second);
@@ -1324,10 +2150,10 @@ void rai::block_processor::process_receive_many (std::unique_lock<std::mutex> &
 	}
 }
 
-rai::process_return rai::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr<rai::block> block_a)
+rai::process_return rai::block_processor::process_receive_one (MDB_txn * transaction_a, std::shared_ptr<rai::block> block_a, rai::signature_verification verification_a)
 {
 	rai::process_return result;
-	result = node.ledger.process (transaction_a, *block_a);
+	result = node.ledger.process (transaction_a, *block_a, verification_a);
 	switch (result.code)
 	{
 		case rai::process_result::progress:
@@ -1338,6 +2164,22 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 				block_a->serialize_json (block);
 				BOOST_LOG (node.log) << boost::str (boost::format ("Processing block %1%: %2%") % block_a->hash ().to_string () % block);
 			}
+			// Start on the work for a wallet account's next block as soon as its frontier moves
+			if (node.wallets.exists (transaction_a, result.account))
+			{
+				node.wallets.work_precache (result.account, block_a->hash ());
+			}
+			// Weight moves from the representative before this block to the one after it, keep wallet representatives in step with both
+			auto representative (representative_of (transaction_a, block_a->hash ()));
+			node.wallets.representative_check (transaction_a, representative);
+			if (!block_a->previous ().is_zero ())
+			{
+				auto previous (representative_of (transaction_a, block_a->previous ()));
+				if (previous != representative)
+				{
+					node.wallets.representative_check (transaction_a, previous);
+				}
+			}
 			break;
 		}
 		case rai::process_result::gap_previous:
@@ -1456,6 +2298,18 @@ rai::process_return rai::block_processor::process_receive_one (MDB_txn * transac
 	return result;
 }
 
+// Representative of the account chain as of block hash_a
+rai::account rai::block_processor::representative_of (MDB_txn * transaction_a, rai::block_hash const & hash_a)
+{
+	rai::account result (0);
+	auto rep_block (node.store.block_get (transaction_a, node.ledger.representative (transaction_a, hash_a)));
+	if (rep_block != nullptr)
+	{
+		result = rep_block->representative ();
+	}
+	return result;
+}
+
 rai::node::node (rai::node_init & init_a, boost::asio::io_service & service_a, uint16_t peering_port_a, boost::filesystem::path const & application_path_a, rai::alarm & alarm_a, rai::logging const & logging_a, rai::work_pool & work_a) :
 node (init_a, service_a, application_path_a, alarm_a, rai::node_config (peering_port_a, logging_a), work_a)
 {
@@ -1477,12 +2331,22 @@ peers (network.endpoint ()),
 application_path (application_path_a),
 wallets (init_a.block_store_init, *this),
 port_mapping (*this),
+checker (config.signature_checker_threads),
 vote_processor (*this),
 warmed_up (0),
 block_processor (*this),
 block_processor_thread ([this]() { this->block_processor.process_blocks (); }),
-online_reps (*this)
+publish_filter (publish_filter_size),
+vote_signatures (*this),
+online_reps (*this),
+store_sync_stopped (false)
 {
+	if (config.lmdb_sync_interval.count () > 0)
+	{
+		// Commits skip fsync, ongoing_store_sync flushes to disk periodically
+		auto status (mdb_env_set_flags (store.environment, MDB_NOSYNC, 1));
+		assert (status == 0);
+	}
 	wallets.observer = [this](bool active) {
 		observers.wallet (active);
 	};
@@ -1689,6 +2553,7 @@ online_reps (*this)
 			}
 		}
 	}
+	wallets.compute_reps ();
 }
 
 rai::node::~node ()
@@ -1816,10 +2681,10 @@ void rai::network::confirm_send (rai::confirm_ack const & confirm_a, std::shared
 	});
 }
 
-void rai::node::process_active (std::shared_ptr<rai::block> incoming)
+bool rai::node::process_active (std::shared_ptr<rai::block> incoming)
 {
 	block_arrival.add (incoming->hash ());
-	block_processor.add (incoming);
+	return block_processor.add (incoming, rai::block_origin::live);
 }
 
 rai::process_return rai::node::process (rai::block const & block_a)
@@ -1966,10 +2831,24 @@ bool rai::parse_tcp_endpoint (std::string const & string, rai::tcp_endpoint & en
 
 void rai::node::start ()
 {
-	network.receive ();
+	network.start ();
 	ongoing_keepalive ();
 	ongoing_bootstrap ();
 	ongoing_store_flush ();
+	if (config.lmdb_sync_interval.count () > 0)
+	{
+		store_sync_thread = std::thread ([this]() { ongoing_store_sync (); });
+	}
+	std::weak_ptr<rai::node> node_w (shared_from_this ());
+	work.request_observers.add ([node_w](rai::work_stats const & stats_a) {
+		if (auto node_l = node_w.lock ())
+		{
+			if (node_l->config.logging.work_generation_time ())
+			{
+				BOOST_LOG (node_l->log) << boost::str (boost::format ("Work for %1% %2% with priority %3% after %4% us queued and %5% us generating") % stats_a.root.to_string () % (stats_a.solved ? "solved" : "cancelled") % static_cast<unsigned> (stats_a.priority) % stats_a.queue_time.count () % stats_a.solve_time.count ());
+			}
+		}
+	});
 	ongoing_rep_crawl ();
 	bootstrap.start ();
 	backup_wallet ();
@@ -1988,12 +2867,31 @@ void rai::node::stop ()
 	{
 		block_processor_thread.join ();
 	}
+	vote_processor.stop ();
+	checker.stop ();
 	active.stop ();
 	network.stop ();
 	bootstrap_initiator.stop ();
 	bootstrap.stop ();
 	port_mapping.stop ();
 	wallets.stop ();
+	{
+		std::lock_guard<std::mutex> lock (store_sync_mutex);
+		store_sync_stopped = true;
+		store_sync_condition.notify_all ();
+	}
+	if (store_sync_thread.joinable ())
+	{
+		store_sync_thread.join ();
+	}
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		store.flush (transaction);
+	}
+	if (config.lmdb_sync_interval.count () > 0)
+	{
+		mdb_env_sync (store.environment, 1);
+	}
 }
 
 void rai::node::keepalive_preconfigured (std::vector<std::string> const & peers_a)
@@ -2108,6 +3006,7 @@ void rai::node::ongoing_bootstrap ()
 void rai::node::ongoing_store_flush ()
 {
 	{
+		// Unchecked blocks whose dependency didn't arrive within the interval are written out so a crash doesn't lose them
 		rai::transaction transaction (store.environment, nullptr, true);
 		store.flush (transaction);
 	}
@@ -2120,6 +3019,22 @@ void rai::node::ongoing_store_flush ()
 	});
 }
 
+void rai::node::ongoing_store_sync ()
+{
+	std::unique_lock<std::mutex> lock (store_sync_mutex);
+	while (!store_sync_stopped)
+	{
+		store_sync_condition.wait_for (lock, config.lmdb_sync_interval);
+		if (!store_sync_stopped)
+		{
+			lock.unlock ();
+			auto status (mdb_env_sync (store.environment, 1));
+			assert (status == 0);
+			lock.lock ();
+		}
+	}
+}
+
 void rai::node::backup_wallet ()
 {
 	rai::transaction transaction (store.environment, nullptr, false);
@@ -2171,8 +3086,9 @@ public:
 class distributed_work : public std::enable_shared_from_this<distributed_work>
 {
 public:
-	distributed_work (std::shared_ptr<rai::node> const & node_a, rai::block_hash const & root_a, std::function<void(uint64_t)> callback_a, unsigned int backoff_a = 1) :
+	distributed_work (std::shared_ptr<rai::node> const & node_a, rai::block_hash const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, rai::work_priority priority_a, unsigned int backoff_a = 1) :
 	callback (callback_a),
+	priority (priority_a),
 	node (node_a),
 	root (root_a),
 	backoff (backoff_a)
@@ -2344,9 +3260,7 @@ public:
 				if (node->config.work_threads != 0 || node->work.opencl)
 				{
 					auto callback_l (callback);
-					node->work.generate (root, [callback_l](boost::optional<uint64_t> const & work_a) {
-						callback_l (work_a.value ());
-					});
+					node->work.generate (root, callback_l, priority);
 				}
 				else
 				{
@@ -2359,10 +3273,11 @@ public:
 					auto callback_l (callback);
 					std::weak_ptr<rai::node> node_w (node);
 					auto next_backoff (std::min (backoff * 2, (unsigned int)60 * 5));
-					node->alarm.add (now + std::chrono::seconds (backoff), [node_w, root_l, callback_l, next_backoff] {
+					auto priority_l (priority);
+					node->alarm.add (now + std::chrono::seconds (backoff), [node_w, root_l, callback_l, priority_l, next_backoff] {
 						if (auto node_l = node_w.lock ())
 						{
-							auto work_generation (std::make_shared<distributed_work> (node_l, root_l, callback_l, next_backoff));
+							auto work_generation (std::make_shared<distributed_work> (node_l, root_l, callback_l, priority_l, next_backoff));
 							work_generation->start ();
 						}
 					});
@@ -2376,7 +3291,8 @@ public:
 		outstanding.erase (address);
 		return outstanding.empty ();
 	}
-	std::function<void(uint64_t)> callback;
+	std::function<void(boost::optional<uint64_t> const &)> callback;
+	rai::work_priority priority;
 	unsigned int backoff; // in seconds
 	std::shared_ptr<rai::node> node;
 	rai::block_hash root;
@@ -2386,24 +3302,30 @@ public:
 };
 }
 
-void rai::node::generate_work (rai::block & block_a)
+void rai::node::generate_work (rai::block & block_a, rai::work_priority priority_a)
 {
-	block_a.block_work_set (generate_work (block_a.root ()));
+	block_a.block_work_set (generate_work (block_a.root (), priority_a));
 }
 
-void rai::node::generate_work (rai::uint256_union const & hash_a, std::function<void(uint64_t)> callback_a)
+void rai::node::generate_work (rai::uint256_union const & hash_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, rai::work_priority priority_a)
 {
-	auto work_generation (std::make_shared<distributed_work> (shared (), hash_a, callback_a));
+	auto work_generation (std::make_shared<distributed_work> (shared (), hash_a, callback_a, priority_a));
 	work_generation->start ();
 }
 
-uint64_t rai::node::generate_work (rai::uint256_union const & hash_a)
+uint64_t rai::node::generate_work (rai::uint256_union const & hash_a, rai::work_priority priority_a)
 {
-	std::promise<uint64_t> promise;
-	generate_work (hash_a, [&promise](uint64_t work_a) {
-		promise.set_value (work_a);
-	});
-	return promise.get_future ().get ();
+	boost::optional<uint64_t> result;
+	while (!result)
+	{
+		std::promise<boost::optional<uint64_t>> promise;
+		generate_work (hash_a, [&promise](boost::optional<uint64_t> const & work_a) {
+			promise.set_value (work_a);
+		},
+		priority_a);
+		result = promise.get_future ().get ();
+	}
+	return *result;
 }
 
 void rai::node::add_initial_peers ()
@@ -2500,6 +3422,47 @@ rai::endpoint rai::network::endpoint ()
 	return rai::endpoint (boost::asio::ip::address_v6::loopback (), port);
 }
 
+rai::block_filter::block_filter (size_t size_a) :
+hits (0),
+misses (0),
+items (size_a, rai::block_hash (0))
+{
+	assert (size_a > 0);
+}
+
+bool rai::block_filter::apply (rai::block_hash const & hash_a)
+{
+	// Digests are uniformly distributed so any part of them can be used as the slot index
+	auto slot (hash_a.qwords[0] % items.size ());
+	bool result;
+	{
+		std::lock_guard<std::mutex> lock (mutexes[slot % mutexes.size ()]);
+		auto & item (items[slot]);
+		result = item == hash_a;
+		item = hash_a;
+	}
+	if (result)
+	{
+		++hits;
+	}
+	else
+	{
+		++misses;
+	}
+	return result;
+}
+
+void rai::block_filter::clear (rai::block_hash const & hash_a)
+{
+	auto slot (hash_a.qwords[0] % items.size ());
+	std::lock_guard<std::mutex> lock (mutexes[slot % mutexes.size ()]);
+	auto & item (items[slot]);
+	if (item == hash_a)
+	{
+		item.clear ();
+	}
+}
+
 void rai::block_arrival::add (rai::block_hash const & hash_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
@@ -2518,6 +3481,63 @@ bool rai::block_arrival::recent (rai::block_hash const & hash_a)
 	return arrival.get<1> ().find (hash_a) != arrival.get<1> ().end ();
 }
 
+rai::vote_signature_cache::vote_signature_cache (rai::node & node_a) :
+hits (0),
+misses (0),
+node (node_a)
+{
+}
+
+std::pair<std::shared_ptr<rai::vote>, std::shared_ptr<std::vector<uint8_t>>> rai::vote_signature_cache::generate (MDB_txn * transaction_a, rai::public_key const & pub_a, rai::raw_key const & prv_a, std::shared_ptr<rai::block> block_a)
+{
+	std::pair<std::shared_ptr<rai::vote>, std::shared_ptr<std::vector<uint8_t>>> result;
+	auto hash (block_a->hash ());
+	auto now (std::chrono::steady_clock::now ());
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		while (!votes.empty () && votes.begin ()->created + freshness < now)
+		{
+			votes.erase (votes.begin ());
+		}
+		auto existing (votes.get<1> ().equal_range (hash));
+		for (auto i (existing.first); i != existing.second && result.first == nullptr; ++i)
+		{
+			if (i->vote->account == pub_a)
+			{
+				result = std::make_pair (i->vote, i->bytes);
+			}
+		}
+	}
+	// A cached vote can only be reused while it still carries the representative's highest sequence number
+	if (result.first != nullptr && result.first->sequence == node.store.vote_sequence (transaction_a, pub_a))
+	{
+		++hits;
+	}
+	else
+	{
+		++misses;
+		result.first = node.store.vote_generate (transaction_a, pub_a, prv_a, block_a);
+		result.second = std::make_shared<std::vector<uint8_t>> ();
+		{
+			rai::confirm_ack confirm (result.first);
+			rai::vectorstream stream (*result.second);
+			confirm.serialize (stream);
+		}
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (votes.get<1> ().equal_range (hash));
+		for (auto i (existing.first); i != existing.second;)
+		{
+			i = i->vote->account == pub_a ? votes.get<1> ().erase (i) : std::next (i);
+		}
+		votes.insert ({ now, hash, result.first, result.second });
+		if (votes.size () > max)
+		{
+			votes.get<0> ().erase (votes.get<0> ().begin ());
+		}
+	}
+	return result;
+}
+
 rai::online_reps::online_reps (rai::node & node) :
 node (node)
 {
@@ -2960,9 +3980,15 @@ confirmation_action (confirmation_action_a),
 votes (block_a),
 node (node_a),
 status ({ block_a, 0 }),
-confirmed (false)
+confirmed (false),
+start (std::chrono::steady_clock::now ()),
+progress (0.0)
 {
 	assert (node_a.store.block_exists (transaction_a, block_a->hash ()));
+	rai::block_sideband sideband;
+	node_a.store.block_get (transaction_a, block_a->hash (), &sideband);
+	// Blocks stored before sideband was introduced don't carry a balance
+	balance = !sideband.account.is_zero () ? sideband.balance : rai::amount (node_a.ledger.balance (transaction_a, block_a->hash ()));
 	compute_rep_votes (transaction_a);
 }
 
@@ -2977,8 +4003,13 @@ void rai::election::compute_rep_votes (MDB_txn * transaction_a)
 void rai::election::broadcast_winner ()
 {
 	rai::transaction transaction (node.store.environment, nullptr, false);
-	compute_rep_votes (transaction);
-	node.network.republish_block (transaction, status.winner);
+	broadcast_winner (transaction);
+}
+
+void rai::election::broadcast_winner (MDB_txn * transaction_a)
+{
+	compute_rep_votes (transaction_a);
+	node.network.republish_block (transaction_a, status.winner);
 }
 
 rai::uint128_t rai::election::quorum_threshold (MDB_txn * transaction_a, rai::ledger & ledger_a)
@@ -3028,6 +4059,7 @@ void rai::election::confirm_once (MDB_txn * transaction_a)
 			}
 		}
 		status.tally = winner->first;
+		node.active.confirmation_latency (std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - start));
 		auto winner_l (status.winner);
 		auto node_l (node.shared ());
 		auto confirmation_action_l (confirmation_action);
@@ -3042,7 +4074,10 @@ bool rai::election::have_quorum (MDB_txn * transaction_a)
 {
 	auto tally_l (node.ledger.tally (transaction_a, votes));
 	assert (tally_l.size () > 0);
-	auto result (tally_l.begin ()->first > quorum_threshold (transaction_a, node.ledger));
+	auto threshold (quorum_threshold (transaction_a, node.ledger));
+	// Fraction of the quorum reached by the leading block, used to prioritise announcements
+	progress = threshold.is_zero () ? 1.0 : tally_l.begin ()->first.convert_to<double> () / threshold.convert_to<double> ();
+	auto result (tally_l.begin ()->first > threshold);
 	return result;
 }
 
@@ -3118,21 +4153,31 @@ bool rai::election::vote (std::shared_ptr<rai::vote> vote_a)
 void rai::active_transactions::announce_votes ()
 {
 	std::vector<rai::block_hash> inactive;
+	std::vector<std::shared_ptr<rai::election>> broadcasts;
 	rai::transaction transaction (node.store.environment, nullptr, false);
 	std::lock_guard<std::mutex> lock (mutex);
 
 	{
-		size_t announcements (0);
-		auto i (roots.begin ());
-		auto n (roots.end ());
-		// Announce our decision for up to `announcements_per_interval' conflicts
-		for (; i != n && announcements < announcements_per_interval; ++i)
+		auto now (std::chrono::steady_clock::now ());
+		std::vector<std::pair<double, decltype (roots.begin ())>> candidates;
+		candidates.reserve (roots.size ());
+		for (auto i (roots.begin ()), n (roots.end ()); i != n; ++i)
+		{
+			candidates.push_back (std::make_pair (priority (*i, now), i));
+		}
+		std::sort (candidates.begin (), candidates.end (), [](std::pair<double, decltype (roots.begin ())> const & lhs, std::pair<double, decltype (roots.begin ())> const & rhs) {
+			return lhs.first > rhs.first;
+		});
+		size_t announced (0);
+		// Announce our decision for up to `election_announce_budget' conflicts, highest priority first
+		for (auto k (candidates.begin ()), m (candidates.end ()); k != m; ++k)
 		{
-			auto election_l (i->election);
-			node.background ([election_l]() { election_l->broadcast_winner (); });
+			auto i (k->second);
+			auto within_budget (announced < node.config.election_announce_budget);
 			if (i->announcements >= contiguous_announcements - 1)
 			{
 				// These blocks have reached the confirmation interval for forks
+				broadcasts.push_back (i->election);
 				i->election->confirm_cutoff (transaction);
 				auto root_l (i->election->votes.id);
 				inactive.push_back (root_l);
@@ -3142,8 +4187,17 @@ void rai::active_transactions::announce_votes ()
 					confirmed.pop_front ();
 				}
 			}
-			else
+			else if (i->election->confirmed)
+			{
+				// Already confirmed by quorum, count down to removal without spending the budget or bandwidth
+				roots.modify (i, [](rai::conflict_info & info_a) {
+					++info_a.announcements;
+				});
+			}
+			else if (within_budget)
 			{
+				++announced;
+				broadcasts.push_back (i->election);
 				unsigned announcements;
 				roots.modify (i, [&announcements](rai::conflict_info & info_a) {
 					announcements = ++info_a.announcements;
@@ -3184,18 +4238,18 @@ void rai::active_transactions::announce_votes ()
 					}
 				}
 			}
-		}
-		// Mark remainder as 0 announcements sent
-		// This could happen if there's a flood of forks, the network will resolve them in increasing root hash order
-		// This is a DoS protection mechanism to rate-limit the amount of traffic for solving forks.
-		for (; i != n; ++i)
-		{
-			// Reset announcement count for conflicts above announcement cutoff
-			roots.modify (i, [](rai::conflict_info & info_a) {
-				info_a.announcements = 0;
-			});
+			else
+			{
+				// Mark remainder as 0 announcements sent
+				// This could happen if there's a flood of forks, the network will resolve them in priority order
+				// This is a DoS protection mechanism to rate-limit the amount of traffic for solving forks.
+				roots.modify (i, [](rai::conflict_info & info_a) {
+					info_a.announcements = 0;
+				});
+			}
 		}
 	}
+	broadcast (broadcasts);
 	for (auto i (inactive.begin ()), n (inactive.end ()); i != n; ++i)
 	{
 		assert (roots.find (*i) != roots.end ());
@@ -3211,6 +4265,82 @@ void rai::active_transactions::announce_votes ()
 	});
 }
 
+// Older and further along elections first, richer accounts break ties, confirmed elections last
+double rai::active_transactions::priority (rai::conflict_info const & info_a, std::chrono::steady_clock::time_point const & now_a)
+{
+	auto result (-1.0);
+	auto election_l (info_a.election);
+	if (!election_l->confirmed)
+	{
+		auto age (std::chrono::duration_cast<std::chrono::milliseconds> (now_a - election_l->start).count ());
+		result = info_a.announcements;
+		result += static_cast<double> (age) / announce_interval_ms;
+		result += std::min (election_l->progress.load (), 1.0);
+		result += std::log2 (election_l->balance.number ().convert_to<double> () + 1.0) / 128.0;
+	}
+	return result;
+}
+
+// Republish winners in batches of `election_broadcast_batch' spread over the interval, each batch under one read transaction
+void rai::active_transactions::broadcast (std::vector<std::shared_ptr<rai::election>> const & elections_a)
+{
+	auto batch_size (std::max<size_t> (node.config.election_broadcast_batch, 1));
+	auto now (std::chrono::steady_clock::now ());
+	std::weak_ptr<rai::node> node_w (node.shared ());
+	for (size_t i (0), n (elections_a.size ()); i < n; i += batch_size)
+	{
+		auto batch (std::make_shared<std::vector<std::shared_ptr<rai::election>>> (elections_a.begin () + i, elections_a.begin () + std::min (i + batch_size, n)));
+		auto action ([node_w, batch]() {
+			if (auto node_l = node_w.lock ())
+			{
+				rai::transaction transaction (node_l->store.environment, nullptr, false);
+				for (auto & election_l : *batch)
+				{
+					election_l->broadcast_winner (transaction);
+				}
+			}
+		});
+		if (i == 0)
+		{
+			node.background (action);
+		}
+		else
+		{
+			node.alarm.add (now + broadcast_interval * (i / batch_size), action);
+		}
+	}
+}
+
+void rai::active_transactions::confirmation_latency (std::chrono::milliseconds const & latency_a)
+{
+	std::lock_guard<std::mutex> lock (latencies_mutex);
+	latencies.push_back (latency_a);
+	if (latencies.size () > election_history_size)
+	{
+		latencies.pop_front ();
+	}
+}
+
+std::vector<std::chrono::milliseconds> rai::active_transactions::latency_percentiles (std::vector<double> const & percentiles_a)
+{
+	std::vector<std::chrono::milliseconds> sorted;
+	{
+		std::lock_guard<std::mutex> lock (latencies_mutex);
+		sorted.assign (latencies.begin (), latencies.end ());
+	}
+	std::vector<std::chrono::milliseconds> result;
+	if (!sorted.empty ())
+	{
+		std::sort (sorted.begin (), sorted.end ());
+		for (auto percentile : percentiles_a)
+		{
+			auto index (static_cast<size_t> (std::ceil (std::max (0.0, std::min (percentile, 1.0)) * sorted.size ())));
+			result.push_back (sorted[index > 0 ? index - 1 : 0]);
+		}
+	}
+	return result;
+}
+
 void rai::active_transactions::stop ()
 {
 	std::lock_guard<std::mutex> lock (mutex);
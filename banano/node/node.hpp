@@ -54,6 +54,7 @@ public:
 	bool have_quorum (MDB_txn *);
 	// Tell the network our view of the winner
 	void broadcast_winner ();
+	void broadcast_winner (MDB_txn *);
 	// Change our winner to agree with the network
 	void compute_rep_votes (MDB_txn *);
 	// Confirmation method 1, uncontested quorum
@@ -67,6 +68,10 @@ public:
 	std::unordered_map<rai::account, std::pair<std::chrono::steady_clock::time_point, uint64_t>> last_votes;
 	rai::election_status status;
 	std::atomic<bool> confirmed;
+	// Scheduling inputs, balance of the account after the block and the leading tally over the quorum threshold as of the last vote
+	std::chrono::steady_clock::time_point start;
+	rai::amount balance;
+	std::atomic<double> progress;
 };
 class conflict_info
 {
@@ -96,6 +101,11 @@ public:
 	// Is the root of this block in the roots container
 	bool active (rai::block const &);
 	void announce_votes ();
+	double priority (rai::conflict_info const &, std::chrono::steady_clock::time_point const &);
+	void broadcast (std::vector<std::shared_ptr<rai::election>> const &);
+	void confirmation_latency (std::chrono::milliseconds const &);
+	// Confirmation latency at each of the percentiles in [0, 1] over recent elections, empty if there aren't any
+	std::vector<std::chrono::milliseconds> latency_percentiles (std::vector<double> const &);
 	std::deque<std::shared_ptr<rai::block>> list_blocks ();
 	void stop ();
 	boost::multi_index_container<
@@ -106,8 +116,11 @@ public:
 	std::deque<rai::election_status> confirmed;
 	rai::node & node;
 	std::mutex mutex;
-	// Maximum number of conflicts to vote on per interval, lowest root hash first
-	static unsigned constexpr announcements_per_interval = 32;
+	// Time from starting to confirming recent elections, separate from mutex as elections confirm while it's held
+	std::deque<std::chrono::milliseconds> latencies;
+	std::mutex latencies_mutex;
+	// Time between batches of winner broadcasts in an interval
+	static std::chrono::milliseconds constexpr broadcast_interval = std::chrono::milliseconds (50);
 	// After this many successive vote announcements, block is confirmed
 	static unsigned constexpr contiguous_announcements = 4;
 	static unsigned constexpr announce_interval_ms = (rai::banano_network == rai::banano_networks::banano_test_network) ? 10 : 16000;
@@ -289,6 +302,11 @@ public:
 	std::atomic<uint64_t> publish;
 	std::atomic<uint64_t> confirm_req;
 	std::atomic<uint64_t> confirm_ack;
+	// Datagrams received, datagrams discarded before being parsed, and how many were handed to a processing thread per wakeup
+	std::atomic<uint64_t> packets;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> batches;
+	std::atomic<uint64_t> batch_packets;
 };
 class block_arrival_info
 {
@@ -311,6 +329,52 @@ public:
 	arrival;
 	std::mutex mutex;
 };
+// Fixed size table of recently published blocks keyed on full_hash, repeats of a block are dropped before being queued for processing
+// A copy with a corrupted signature or work gets its own entry rather than shadowing the genuine block
+class block_filter
+{
+public:
+	block_filter (size_t);
+	// Returns true if the digest was recently seen, otherwise records it
+	bool apply (rai::block_hash const &);
+	// Forgets the digest so the next arrival is let through
+	void clear (rai::block_hash const &);
+	std::atomic<uint64_t> hits;
+	std::atomic<uint64_t> misses;
+
+private:
+	std::vector<rai::block_hash> items;
+	std::array<std::mutex, 64> mutexes;
+};
+class vote_signature_info
+{
+public:
+	std::chrono::steady_clock::time_point created;
+	rai::block_hash hash;
+	std::shared_ptr<rai::vote> vote;
+	std::shared_ptr<std::vector<uint8_t>> bytes;
+};
+// Recently generated votes and their serialized confirm_ack, repeat confirm_reqs for a block are answered without signing again
+class vote_signature_cache
+{
+public:
+	vote_signature_cache (rai::node &);
+	// Returns a vote by the representative for the block along with its confirm_ack bytes
+	std::pair<std::shared_ptr<rai::vote>, std::shared_ptr<std::vector<uint8_t>>> generate (MDB_txn *, rai::public_key const &, rai::raw_key const &, std::shared_ptr<rai::block>);
+	boost::multi_index_container<
+	rai::vote_signature_info,
+	boost::multi_index::indexed_by<
+	boost::multi_index::ordered_non_unique<boost::multi_index::member<rai::vote_signature_info, std::chrono::steady_clock::time_point, &rai::vote_signature_info::created>>,
+	boost::multi_index::hashed_non_unique<boost::multi_index::member<rai::vote_signature_info, rai::block_hash, &rai::vote_signature_info::hash>>>>
+	votes;
+	std::atomic<uint64_t> hits;
+	std::atomic<uint64_t> misses;
+	std::mutex mutex;
+	rai::node & node;
+	static size_t constexpr max = 4096;
+	// Votes older than this are signed again
+	static std::chrono::seconds constexpr freshness = std::chrono::seconds (15);
+};
 class rep_last_heard_info
 {
 public:
@@ -337,13 +401,49 @@ private:
 	std::mutex mutex;
 	rai::node & node;
 };
+class udp_data
+{
+public:
+	uint8_t * buffer;
+	size_t size;
+	rai::endpoint endpoint;
+};
+/**
+ * A ring of receive buffers shared between the sockets filling them and the threads parsing them.
+ * If datagrams are not serviced fast enough the oldest unprocessed ones are dropped.
+ */
+class udp_buffer
+{
+public:
+	udp_buffer (rai::message_statistics &, size_t, size_t);
+	// Returns a free buffer, reusing the oldest queued datagram if none are free. Returns nullptr once stopped
+	rai::udp_data * allocate ();
+	void enqueue (rai::udp_data *);
+	// Blocks until datagrams are queued and moves up to the given count of them in to the vector, returns false once stopped
+	bool dequeue (std::vector<rai::udp_data *> &, size_t);
+	void release (rai::udp_data *);
+	void stop ();
+
+private:
+	rai::message_statistics & stats;
+	std::mutex mutex;
+	std::condition_variable condition;
+	boost::circular_buffer<rai::udp_data *> free;
+	boost::circular_buffer<rai::udp_data *> full;
+	std::vector<uint8_t> slab;
+	std::vector<rai::udp_data> entries;
+	bool stopped;
+};
 class network
 {
 public:
 	network (rai::node &, uint16_t);
+	~network ();
+	void start ();
 	void receive ();
 	void stop ();
-	void receive_action (boost::system::error_code const &, size_t);
+	void process_packets ();
+	void receive_action (rai::udp_data *);
 	void rpc_action (boost::system::error_code const &, size_t);
 	void rebroadcast_reps (std::shared_ptr<rai::block>);
 	void republish_vote (std::shared_ptr<rai::vote>);
@@ -358,18 +458,21 @@ public:
 	void send_confirm_req (rai::endpoint const &, std::shared_ptr<rai::block>);
 	void send_buffer (uint8_t const *, size_t, rai::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
 	rai::endpoint endpoint ();
-	rai::endpoint remote;
-	std::array<uint8_t, 512> buffer;
 	boost::asio::ip::udp::socket socket;
 	std::mutex socket_mutex;
 	boost::asio::ip::udp::resolver resolver;
 	rai::node & node;
-	uint64_t bad_sender_count;
-	bool on;
-	uint64_t insufficient_work_count;
-	uint64_t error_count;
+	std::atomic<uint64_t> bad_sender_count;
+	std::atomic<bool> on;
+	std::atomic<uint64_t> insufficient_work_count;
+	std::atomic<uint64_t> error_count;
 	rai::message_statistics incoming;
 	rai::message_statistics outgoing;
+	rai::udp_buffer buffer_container;
+	std::vector<std::thread> packet_processing_threads;
+	static size_t constexpr buffer_size = 512;
+	static size_t constexpr buffer_count = 4096;
+	static size_t constexpr batch_max = 64;
 	static uint16_t const node_port = rai::banano_network == rai::banano_networks::banano_live_network ? 7071 : 54000;
 };
 class logging
@@ -452,6 +555,17 @@ public:
 	int lmdb_max_dbs;
 	rai::block_hash state_block_parse_canary;
 	rai::block_hash state_block_generate_canary;
+	unsigned signature_checker_threads;
+	unsigned network_threads;
+	// Most blocks and longest time the block processor holds a write transaction, trading commit latency for throughput
+	unsigned block_processor_batch_max_blocks;
+	std::chrono::milliseconds block_processor_batch_max_time;
+	// When non-zero the store is opened without fsync on commit and synced on this interval instead
+	std::chrono::milliseconds lmdb_sync_interval;
+	// Elections announced per announcement interval, highest priority first, and how many winners are broadcast at a time
+	unsigned election_announce_budget;
+	unsigned election_broadcast_batch;
+	unsigned vote_processor_threads;
 	static std::chrono::seconds constexpr keepalive_period = std::chrono::seconds (60);
 	static std::chrono::seconds constexpr keepalive_cutoff = keepalive_period * 5;
 	static std::chrono::minutes constexpr wallet_backup_interval = std::chrono::minutes (5);
@@ -467,12 +581,42 @@ public:
 	rai::observer_set<> disconnect;
 	rai::observer_set<> started;
 };
+// Votes received from the network are queued here and validated by worker threads so receiving packets is never held up
 class vote_processor
 {
 public:
 	vote_processor (rai::node &);
-	rai::vote_result vote (std::shared_ptr<rai::vote>, rai::endpoint);
+	~vote_processor ();
+	// Returns true if the vote was dropped because the queue is full
+	bool add (std::shared_ptr<rai::vote>, rai::endpoint const &);
+	rai::vote_result vote (std::shared_ptr<rai::vote>, rai::endpoint, rai::signature_verification = rai::signature_verification::unknown);
+	void flush ();
+	void stop ();
+	size_t size ();
 	rai::node & node;
+	std::atomic<uint64_t> dropped;
+	// Above these queue depths only votes from representatives with at least 0.1% and 1% of online stake are accepted
+	static size_t constexpr tier_1_size = 4096;
+	static size_t constexpr tier_2_size = 8192;
+	static size_t constexpr max_size = 12288;
+	static size_t constexpr batch_max = 1024;
+
+private:
+	void process_loop ();
+	void verify_votes (std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> &, std::vector<int> &);
+	void update_tiers (std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> &, std::vector<int> &);
+	void seed_tiers ();
+	void place (rai::account const &, rai::uint128_t const &, rai::uint128_t const &);
+	bool should_log ();
+	std::deque<std::pair<std::shared_ptr<rai::vote>, rai::endpoint>> votes;
+	std::unordered_set<rai::account> representatives_1;
+	std::unordered_set<rai::account> representatives_2;
+	bool stopped;
+	unsigned active;
+	std::chrono::steady_clock::time_point next_log;
+	std::condition_variable condition;
+	std::mutex mutex;
+	std::vector<std::thread> threads;
 };
 // The network is crawled for representatives by occasionally sending a unicast confirm_req for a specific block and watching to see if it's acknowledged with a vote.
 class rep_crawler
@@ -486,6 +630,51 @@ public:
 };
 // Processing blocks is a potentially long IO operation
 // This class isolates block insertion from other operations like servicing network operations
+class signature_check_set
+{
+public:
+	size_t size;
+	unsigned char const ** messages;
+	size_t * message_lengths;
+	unsigned char const ** pub_keys;
+	unsigned char const ** signatures;
+	int * verifications;
+};
+// Verifies sets of ed25519 signatures in batches, large sets are split across a pool of threads
+class signature_checker
+{
+public:
+	signature_checker (unsigned);
+	~signature_checker ();
+	void verify (rai::signature_check_set &);
+	void stop ();
+	static size_t constexpr batch_size = 256;
+
+private:
+	void run ();
+	void verify_batch (rai::signature_check_set &, size_t, size_t);
+	bool stopped;
+	std::deque<std::function<void()>> tasks;
+	std::condition_variable condition;
+	std::mutex mutex;
+	std::vector<std::thread> threads;
+};
+// Where a block entering the block processor came from, each origin is queued separately
+enum class block_origin : uint8_t
+{
+	live = 0,
+	bootstrap = 1,
+	unchecked = 2,
+	local = 3
+};
+class block_processor_item
+{
+public:
+	std::shared_ptr<rai::block> block;
+	rai::signature_verification verification;
+	std::chrono::steady_clock::time_point arrival;
+};
+// Group commit engine for incoming blocks, each write transaction processes a batch bounded by node_config
 class block_processor
 {
 public:
@@ -493,20 +682,52 @@ public:
 	~block_processor ();
 	void stop ();
 	void flush ();
-	void add (std::shared_ptr<rai::block>);
+	// Returns true if the origin's queue is full and the block was dropped
+	bool add (std::shared_ptr<rai::block>, rai::block_origin = rai::block_origin::local);
+	// Returns true if any block was dropped, those are appended to the last argument in order when it's given
+	bool add (std::vector<std::shared_ptr<rai::block>> const &, rai::block_origin = rai::block_origin::local, std::vector<std::shared_ptr<rai::block>> * = nullptr);
 	void force (std::shared_ptr<rai::block>);
+	size_t queue_size (rai::block_origin);
+	// Producers able to slow down, such as bootstrap pulls, should hold off while their queue is saturated
+	bool saturated (rai::block_origin);
 	bool should_log ();
 	bool have_blocks ();
 	void process_blocks ();
-	rai::process_return process_receive_one (MDB_txn *, std::shared_ptr<rai::block>);
+	rai::process_return process_receive_one (MDB_txn *, std::shared_ptr<rai::block>, rai::signature_verification = rai::signature_verification::unknown);
+	static size_t constexpr verification_max = 2048;
+	static size_t constexpr queue_max = 64 * 1024;
+	static size_t constexpr origins = 4;
+	// Bucket i counts blocks which waited less than 2^i milliseconds in their queue, the last bucket counts the rest
+	static size_t constexpr wait_buckets = 12;
+	std::array<std::array<std::atomic<uint64_t>, wait_buckets>, origins> wait_times;
+	std::array<std::atomic<uint64_t>, origins> dropped;
+	// Metrics of the most recently committed batch
+	std::atomic<uint64_t> batches;
+	std::atomic<uint64_t> batch_size;
+	std::atomic<uint64_t> batch_commit_us;
+	std::atomic<uint64_t> batch_blocks_per_sec;
 
 private:
 	void process_receive_many (std::unique_lock<std::mutex> &);
+	void select_blocks (std::vector<rai::block_processor_item> &, size_t);
+	void verify_state_blocks (std::vector<rai::block_processor_item> &);
+	bool have_verified ();
+	void log_queues ();
+	rai::account representative_of (MDB_txn *, rai::block_hash const &);
 	bool stopped;
 	bool active;
 	std::chrono::steady_clock::time_point next_log;
-	std::deque<std::shared_ptr<rai::block>> blocks;
+	// Incoming blocks by origin, drained by weighted round robin so bootstrap can't starve live traffic
+	// Every queue is taken from the front, bootstrap is filled from the front as well so it's last in first out
+	std::array<std::deque<rai::block_processor_item>, origins> queues;
+	size_t next_queue;
+	unsigned queue_credit;
+	// Selected blocks whose signatures have been checked, waiting for a write transaction
+	std::deque<std::pair<std::shared_ptr<rai::block>, rai::signature_verification>> blocks;
 	std::deque<std::shared_ptr<rai::block>> forced;
+	std::vector<rai::block_processor_item> selected;
+	// Reused between batches to avoid reallocating
+	std::vector<std::pair<std::shared_ptr<rai::block>, rai::process_return>> progress;
 	std::condition_variable condition;
 	rai::node & node;
 	std::mutex mutex;
@@ -531,7 +752,8 @@ public:
 	int store_version ();
 	void process_confirmed (std::shared_ptr<rai::block>);
 	void process_message (rai::message &, rai::endpoint const &);
-	void process_active (std::shared_ptr<rai::block>);
+	// Returns true if the live queue is full and the block was dropped
+	bool process_active (std::shared_ptr<rai::block>);
 	rai::process_return process (rai::block const &);
 	void keepalive_preconfigured (std::vector<std::string> const &);
 	rai::block_hash latest (rai::account const &);
@@ -544,11 +766,14 @@ public:
 	void ongoing_rep_crawl ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_store_sync ();
 	void backup_wallet ();
 	int price (rai::uint128_t const &, int);
-	void generate_work (rai::block &);
-	uint64_t generate_work (rai::uint256_union const &);
-	void generate_work (rai::uint256_union const &, std::function<void(uint64_t)>);
+	void generate_work (rai::block &, rai::work_priority = rai::work_priority::wallet);
+	// Requests again if the shared request for the root is cancelled or expires, for callers which need the work
+	uint64_t generate_work (rai::uint256_union const &, rai::work_priority = rai::work_priority::wallet);
+	// Called with none if local generation is cancelled or passes its deadline
+	void generate_work (rai::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>, rai::work_priority = rai::work_priority::wallet);
 	void add_initial_peers ();
 	boost::asio::io_service & service;
 	rai::node_config config;
@@ -567,13 +792,22 @@ public:
 	rai::node_observers observers;
 	rai::wallets wallets;
 	rai::port_mapping port_mapping;
+	rai::signature_checker checker;
 	rai::vote_processor vote_processor;
 	rai::rep_crawler rep_crawler;
 	unsigned warmed_up;
 	rai::block_processor block_processor;
 	std::thread block_processor_thread;
 	rai::block_arrival block_arrival;
+	rai::block_filter publish_filter;
+	rai::vote_signature_cache vote_signatures;
 	rai::online_reps online_reps;
+	// ongoing_store_sync runs here since fsync blocks for as long as the disk takes, which would stall the I/O threads
+	bool store_sync_stopped;
+	std::mutex store_sync_mutex;
+	std::condition_variable store_sync_condition;
+	std::thread store_sync_thread;
+	static size_t constexpr publish_filter_size = 256 * 1024;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
 	static std::chrono::seconds constexpr period = std::chrono::seconds (60);
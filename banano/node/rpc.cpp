@@ -53,7 +53,11 @@ address (boost::asio::ip::address_v6::loopback ()),
 port (rai::rpc::rpc_port),
 enable_control (false),
 frontier_request_limit (16384),
-chain_request_limit (16384)
+chain_request_limit (16384),
+keepalive_requests (1000),
+keepalive_timeout (std::chrono::seconds (30)),
+executor_threads (std::max (4u, std::thread::hardware_concurrency ())),
+scan_concurrency (std::max (1u, executor_threads / 2))
 {
 }
 
@@ -62,7 +66,11 @@ address (boost::asio::ip::address_v6::loopback ()),
 port (rai::rpc::rpc_port),
 enable_control (enable_control_a),
 frontier_request_limit (16384),
-chain_request_limit (16384)
+chain_request_limit (16384),
+keepalive_requests (1000),
+keepalive_timeout (std::chrono::seconds (30)),
+executor_threads (std::max (4u, std::thread::hardware_concurrency ())),
+scan_concurrency (std::max (1u, executor_threads / 2))
 {
 }
 
@@ -73,6 +81,10 @@ void rai::rpc_config::serialize_json (boost::property_tree::ptree & tree_a) cons
 	tree_a.put ("enable_control", enable_control);
 	tree_a.put ("frontier_request_limit", frontier_request_limit);
 	tree_a.put ("chain_request_limit", chain_request_limit);
+	tree_a.put ("keepalive_requests", keepalive_requests);
+	tree_a.put ("keepalive_timeout", keepalive_timeout.count ());
+	tree_a.put ("executor_threads", executor_threads);
+	tree_a.put ("scan_concurrency", scan_concurrency);
 }
 
 bool rai::rpc_config::deserialize_json (boost::property_tree::ptree const & tree_a)
@@ -93,12 +105,23 @@ bool rai::rpc_config::deserialize_json (boost::property_tree::ptree const & tree
 			enable_control = tree_a.get<bool> ("enable_control");
 			auto frontier_request_limit_l (tree_a.get<std::string> ("frontier_request_limit"));
 			auto chain_request_limit_l (tree_a.get<std::string> ("chain_request_limit"));
+			// Optional so existing config files keep loading
+			auto keepalive_requests_l (tree_a.get<std::string> ("keepalive_requests", std::to_string (keepalive_requests)));
+			auto keepalive_timeout_l (tree_a.get<std::string> ("keepalive_timeout", std::to_string (keepalive_timeout.count ())));
+			auto executor_threads_l (tree_a.get<std::string> ("executor_threads", std::to_string (executor_threads)));
+			auto scan_concurrency_l (tree_a.get<std::string> ("scan_concurrency", std::to_string (scan_concurrency)));
 			try
 			{
 				port = std::stoul (port_l);
 				result = port > std::numeric_limits<uint16_t>::max ();
 				frontier_request_limit = std::stoull (frontier_request_limit_l);
 				chain_request_limit = std::stoull (chain_request_limit_l);
+				keepalive_requests = std::stoul (keepalive_requests_l);
+				keepalive_timeout = std::chrono::seconds (std::stoul (keepalive_timeout_l));
+				executor_threads = std::stoul (executor_threads_l);
+				scan_concurrency = std::stoul (scan_concurrency_l);
+				// One thread is kept for point requests so there have to be at least two
+				result = result || executor_threads < 2 || scan_concurrency == 0;
 			}
 			catch (std::logic_error const &)
 			{
@@ -119,13 +142,121 @@ bool rai::rpc_config::deserialize_json (boost::property_tree::ptree const & tree
 	return result;
 }
 
+rai::rpc_queue_stats::rpc_queue_stats () :
+requests (0),
+queued (0),
+active (0),
+queue_time (0),
+queue_time_max (0)
+{
+}
+
+rai::rpc_executor::rpc_executor (unsigned threads_a, unsigned scan_concurrency_a) :
+stopped (false)
+{
+	// Scans always leave a thread free for point requests
+	auto count (std::max (2u, threads_a));
+	queues[static_cast<size_t> (rai::rpc_request_class::point)].limit = count;
+	queues[static_cast<size_t> (rai::rpc_request_class::scan)].limit = std::min (std::max (1u, scan_concurrency_a), count - 1);
+	for (auto i (0u); i < count; ++i)
+	{
+		threads.push_back (std::thread ([this]() {
+			run ();
+		}));
+	}
+}
+
+rai::rpc_executor::~rpc_executor ()
+{
+	stop ();
+	for (auto & i : threads)
+	{
+		i.join ();
+	}
+}
+
+void rai::rpc_executor::add (rai::rpc_request_class class_a, std::function<void()> const & action_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	if (!stopped)
+	{
+		queues[static_cast<size_t> (class_a)].items.push_back (std::make_pair (std::chrono::steady_clock::now (), action_a));
+		condition.notify_all ();
+	}
+}
+
+void rai::rpc_executor::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		// Point requests go first, a scan only starts while the scan limit allows it
+		auto selected (std::find_if (queues.begin (), queues.end (), [](rai::rpc_queue const & queue_a) { return !queue_a.items.empty () && queue_a.stats.active < queue_a.limit; }));
+		if (selected != queues.end ())
+		{
+			auto item (std::move (selected->items.front ()));
+			selected->items.pop_front ();
+			auto queue_time (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - item.first));
+			++selected->stats.requests;
+			++selected->stats.active;
+			selected->stats.queue_time += queue_time;
+			selected->stats.queue_time_max = std::max (selected->stats.queue_time_max, queue_time);
+			lock.unlock ();
+			item.second ();
+			// Release whatever the handler captured before taking the lock again
+			item.second = nullptr;
+			lock.lock ();
+			--selected->stats.active;
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void rai::rpc_executor::stop ()
+{
+	std::array<rai::rpc_queue, 2> dropped;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		for (auto i (0u); i < queues.size (); ++i)
+		{
+			dropped[i].items.swap (queues[i].items);
+		}
+		condition.notify_all ();
+	}
+}
+
+rai::rpc_queue_stats rai::rpc_executor::stats (rai::rpc_request_class class_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto & queue (queues[static_cast<size_t> (class_a)]);
+	auto result (queue.stats);
+	result.queued = queue.items.size ();
+	return result;
+}
+
 rai::rpc::rpc (boost::asio::io_service & service_a, rai::node & node_a, rai::rpc_config const & config_a) :
 acceptor (service_a),
 config (config_a),
-node (node_a)
+node (node_a),
+stopped (false),
+connections (0),
+requests (0),
+executor (config_a.executor_threads, config_a.scan_concurrency)
 {
 }
 
+rai::rpc::~rpc ()
+{
+	// The executor joins its threads after this
+	stopped = true;
+	cancel_work ();
+}
+
 void rai::rpc::start ()
 {
 	auto endpoint (rai::tcp_endpoint (config.address, config.port));
@@ -155,6 +286,7 @@ void rai::rpc::accept ()
 		if (!ec)
 		{
 			accept ();
+			connection_add (connection);
 			connection->parse_connection ();
 		}
 		else
@@ -166,15 +298,223 @@ void rai::rpc::accept ()
 
 void rai::rpc::stop ()
 {
+	stopped = true;
 	acceptor.close ();
+	std::vector<std::shared_ptr<rai::rpc_connection>> open_l;
+	{
+		std::lock_guard<std::mutex> lock (connections_mutex);
+		for (auto & i : open)
+		{
+			auto connection (i.lock ());
+			if (connection != nullptr)
+			{
+				open_l.push_back (connection);
+			}
+		}
+	}
+	// Connections in the middle of a request close once they've responded
+	for (auto & i : open_l)
+	{
+		node.background ([i]() {
+			i->close_idle ();
+		});
+	}
+	cancel_work ();
 }
 
-rai::rpc_handler::rpc_handler (rai::node & node_a, rai::rpc & rpc_a, std::string const & body_a, std::function<void(boost::property_tree::ptree const &)> const & response_a) :
+boost::optional<uint64_t> rai::rpc::generate_work (rai::uint256_union const & root_a)
+{
+	boost::optional<uint64_t> result;
+	std::unique_lock<std::mutex> lock (work_mutex);
+	if (!stopped)
+	{
+		work_pending.insert (root_a);
+		std::promise<boost::optional<uint64_t>> promise;
+		// Queued while holding the lock so cancel_work can't miss the request
+		node.generate_work (root_a, [&promise](boost::optional<uint64_t> const & work_a) {
+			promise.set_value (work_a);
+		},
+		rai::work_priority::rpc);
+		lock.unlock ();
+		result = promise.get_future ().get ();
+		lock.lock ();
+		work_pending.erase (work_pending.find (root_a));
+	}
+	return result;
+}
+
+void rai::rpc::cancel_work ()
+{
+	std::vector<rai::uint256_union> roots;
+	{
+		std::lock_guard<std::mutex> lock (work_mutex);
+		roots.assign (work_pending.begin (), work_pending.end ());
+	}
+	for (auto & i : roots)
+	{
+		node.work.cancel (i);
+	}
+}
+
+void rai::rpc::connection_add (std::shared_ptr<rai::rpc_connection> connection_a)
+{
+	++connections;
+	std::lock_guard<std::mutex> lock (connections_mutex);
+	open.erase (std::remove_if (open.begin (), open.end (), [](std::weak_ptr<rai::rpc_connection> const & connection_a) { return connection_a.expired (); }), open.end ());
+	open.push_back (connection_a);
+}
+
+size_t rai::rpc::connections_open ()
+{
+	std::lock_guard<std::mutex> lock (connections_mutex);
+	return std::count_if (open.begin (), open.end (), [](std::weak_ptr<rai::rpc_connection> const & connection_a) { return !connection_a.expired (); });
+}
+
+rai::rpc_handler::rpc_handler (rai::node & node_a, rai::rpc & rpc_a, std::string const & body_a, std::function<void(std::string)> const & response_a) :
 body (body_a),
 node (node_a),
 rpc (rpc_a),
-response (response_a)
+response ([response_a](boost::property_tree::ptree const & tree_a) {
+	std::stringstream ostream;
+	boost::property_tree::write_json (ostream, tree_a);
+	ostream.flush ();
+	response_a (ostream.str ());
+}),
+response_body (response_a)
+{
+}
+
+rai::json_writer::json_writer (std::string & buffer_a) :
+buffer (buffer_a)
+{
+}
+
+void rai::json_writer::begin_object (std::string const & key_a)
+{
+	if (!levels.empty ())
+	{
+		child (key_a);
+	}
+	levels.push_back (level{ false, true });
+}
+
+void rai::json_writer::begin_array (std::string const & key_a)
+{
+	if (!levels.empty ())
+	{
+		child (key_a);
+	}
+	levels.push_back (level{ true, true });
+}
+
+void rai::json_writer::end ()
+{
+	assert (!levels.empty ());
+	auto & level (levels.back ());
+	if (level.empty && levels.size () > 1)
+	{
+		// A ptree node without children is written as an empty value
+		buffer.append ("\"\"");
+	}
+	else if (level.empty)
+	{
+		buffer.append ("{\n}");
+	}
+	else
+	{
+		buffer.push_back ('\n');
+		buffer.append (4 * (levels.size () - 1), ' ');
+		buffer.push_back (level.array ? ']' : '}');
+	}
+	levels.pop_back ();
+	if (levels.empty ())
+	{
+		buffer.push_back ('\n');
+	}
+}
+
+void rai::json_writer::put (std::string const & key_a, std::string const & value_a)
+{
+	child (key_a);
+	buffer.push_back ('"');
+	escape (value_a);
+	buffer.push_back ('"');
+}
+
+void rai::json_writer::push_back (std::string const & value_a)
+{
+	put (std::string (), value_a);
+}
+
+// Opens the enclosing object or array on its first child and writes the child's indentation and key
+void rai::json_writer::child (std::string const & key_a)
 {
+	assert (!levels.empty ());
+	auto & level (levels.back ());
+	if (level.empty)
+	{
+		buffer.push_back (level.array ? '[' : '{');
+		buffer.push_back ('\n');
+		level.empty = false;
+	}
+	else
+	{
+		buffer.append (",\n");
+	}
+	buffer.append (4 * levels.size (), ' ');
+	if (!level.array)
+	{
+		buffer.push_back ('"');
+		escape (key_a);
+		buffer.append ("\": ");
+	}
+}
+
+// Same escaping as write_json, control characters without a short escape are written as \u00XX
+void rai::json_writer::escape (std::string const & text_a)
+{
+	static char const * hex ("0123456789ABCDEF");
+	auto plain (text_a.begin ());
+	for (auto i (text_a.begin ()), n (text_a.end ()); i != n; ++i)
+	{
+		auto c (static_cast<unsigned char> (*i));
+		if (c < 0x20 || c == '"' || c == '/' || c == '\\')
+		{
+			// Copy the run of characters needing no escape in one go
+			buffer.append (plain, i);
+			plain = i + 1;
+			buffer.push_back ('\\');
+			switch (c)
+			{
+				case '\b':
+					buffer.push_back ('b');
+					break;
+				case '\f':
+					buffer.push_back ('f');
+					break;
+				case '\n':
+					buffer.push_back ('n');
+					break;
+				case '\r':
+					buffer.push_back ('r');
+					break;
+				case '\t':
+					buffer.push_back ('t');
+					break;
+				case '"':
+				case '/':
+				case '\\':
+					buffer.push_back (*i);
+					break;
+				default:
+					buffer.append ("u00");
+					buffer.push_back (hex[c >> 4]);
+					buffer.push_back (hex[c & 0xf]);
+					break;
+			}
+		}
+	}
+	buffer.append (plain, text_a.end ());
 }
 
 void rai::rpc::observer_action (rai::account const & account_a)
@@ -517,6 +857,7 @@ void rai::rpc_handler::account_remove ()
 						if (account != wallet->store.end ())
 						{
 							wallet->store.erase (transaction, account_id);
+							node.wallets.representative_check (transaction, account_id);
 							boost::property_tree::ptree response_l;
 							response_l.put ("removed", "1");
 							response (response_l);
@@ -786,77 +1127,115 @@ void rai::rpc_handler::accounts_frontiers ()
 	response (response_l);
 }
 
+namespace
+{
+// Writes the pending blocks of account_a as accounts_pending and wallet_pending report them, an account with none is only written if always_a
+void pending_write (rai::json_writer & writer_a, rai::node & node_a, MDB_txn * transaction_a, rai::account const & account_a, uint64_t count_a, rai::uint128_union const & threshold_a, bool source_a, bool always_a)
+{
+	auto hashes_only (threshold_a.is_zero () && !source_a);
+	uint64_t written (0);
+	rai::account end (account_a.number () + 1);
+	for (auto i (node_a.store.pending_begin (transaction_a, rai::pending_key (account_a, 0))), n (node_a.store.pending_begin (transaction_a, rai::pending_key (end, 0))); i != n && written < count_a; ++i)
+	{
+		rai::pending_key key (i->first);
+		if (hashes_only)
+		{
+			if (written == 0)
+			{
+				writer_a.begin_array (account_a.to_account ());
+			}
+			writer_a.push_back (key.hash.to_string ());
+			++written;
+		}
+		else
+		{
+			rai::pending_info info (i->second);
+			if (info.amount.number () >= threshold_a.number ())
+			{
+				if (written == 0)
+				{
+					writer_a.begin_object (account_a.to_account ());
+				}
+				if (source_a)
+				{
+					writer_a.begin_object (key.hash.to_string ());
+					writer_a.put ("amount", info.amount.number ().convert_to<std::string> ());
+					writer_a.put ("source", info.source.to_account ());
+					writer_a.end ();
+				}
+				else
+				{
+					writer_a.put (key.hash.to_string (), info.amount.number ().convert_to<std::string> ());
+				}
+				++written;
+			}
+		}
+	}
+	if (written == 0 && always_a)
+	{
+		writer_a.begin_object (account_a.to_account ());
+	}
+	if (written > 0 || always_a)
+	{
+		writer_a.end ();
+	}
+}
+}
+
 void rai::rpc_handler::accounts_pending ()
 {
 	uint64_t count (std::numeric_limits<uint64_t>::max ());
 	rai::uint128_union threshold (0);
+	auto error (false);
 	boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
 	if (count_text.is_initialized ())
 	{
-		auto error (decode_unsigned (count_text.get (), count));
+		error = decode_unsigned (count_text.get (), count);
 		if (error)
 		{
 			error_response (response, "Invalid count limit");
 		}
 	}
 	boost::optional<std::string> threshold_text (request.get_optional<std::string> ("threshold"));
-	if (threshold_text.is_initialized ())
+	if (!error && threshold_text.is_initialized ())
 	{
-		auto error_threshold (threshold.decode_dec (threshold_text.get ()));
-		if (error_threshold)
+		error = threshold.decode_dec (threshold_text.get ());
+		if (error)
 		{
 			error_response (response, "Bad threshold number");
 		}
 	}
-	const bool source = request.get<bool> ("source", false);
-	boost::property_tree::ptree response_l;
-	boost::property_tree::ptree pending;
-	rai::transaction transaction (node.store.environment, nullptr, false);
-	for (auto & accounts : request.get_child ("accounts"))
+	if (!error)
 	{
-		std::string account_text = accounts.second.data ();
-		rai::uint256_union account;
-		if (!account.decode_account (account_text))
+		const bool source = request.get<bool> ("source", false);
+		std::vector<rai::account> accounts;
+		auto accounts_l (request.get_child ("accounts"));
+		for (auto i (accounts_l.begin ()), n (accounts_l.end ()); !error && i != n; ++i)
 		{
-			boost::property_tree::ptree peers_l;
-			rai::account end (account.number () + 1);
-			for (auto i (node.store.pending_begin (transaction, rai::pending_key (account, 0))), n (node.store.pending_begin (transaction, rai::pending_key (end, 0))); i != n && peers_l.size () < count; ++i)
+			rai::account account;
+			error = account.decode_account (i->second.data ());
+			accounts.push_back (account);
+		}
+		if (!error)
+		{
+			std::string body_l;
+			rai::json_writer writer (body_l);
+			writer.begin_object ();
+			writer.begin_object ("blocks");
+			rai::transaction transaction (node.store.environment, nullptr, false);
+			for (auto & account : accounts)
 			{
-				rai::pending_key key (i->first);
-				if (threshold.is_zero () && !source)
-				{
-					boost::property_tree::ptree entry;
-					entry.put ("", key.hash.to_string ());
-					peers_l.push_back (std::make_pair ("", entry));
-				}
-				else
-				{
-					rai::pending_info info (i->second);
-					if (info.amount.number () >= threshold.number ())
-					{
-						if (source)
-						{
-							boost::property_tree::ptree pending_tree;
-							pending_tree.put ("amount", info.amount.number ().convert_to<std::string> ());
-							pending_tree.put ("source", info.source.to_account ());
-							peers_l.add_child (key.hash.to_string (), pending_tree);
-						}
-						else
-						{
-							peers_l.put (key.hash.to_string (), info.amount.number ().convert_to<std::string> ());
-						}
-					}
-				}
+				pending_write (writer, node, transaction, account, count, threshold, source, true);
 			}
-			pending.add_child (account.to_account (), peers_l);
+			writer.end ();
+			writer.end ();
+			response_body (std::move (body_l));
 		}
 		else
 		{
 			error_response (response, "Bad account number");
 		}
 	}
-	response_l.add_child ("blocks", pending);
-	response (response_l);
 }
 
 void rai::rpc_handler::available_supply ()
@@ -1242,15 +1621,22 @@ void rai::rpc_handler::block_create ()
 				{
 					if (work == 0)
 					{
-						work = node.generate_work (previous.is_zero () ? pub : previous);
+						work = rpc.generate_work (previous.is_zero () ? pub : previous).value_or (0);
+					}
+					if (work != 0)
+					{
+						rai::state_block state (pub, previous, representative, balance, link, prv, pub, work);
+						boost::property_tree::ptree response_l;
+						response_l.put ("hash", state.hash ().to_string ());
+						std::string contents;
+						state.serialize_json (contents);
+						response_l.put ("block", contents);
+						response (response_l);
+					}
+					else
+					{
+						error_response (response, "Work generation cancelled");
 					}
-					rai::state_block state (pub, previous, representative, balance, link, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", state.hash ().to_string ());
-					std::string contents;
-					state.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
 				}
 				else
 				{
@@ -1263,15 +1649,22 @@ void rai::rpc_handler::block_create ()
 				{
 					if (work == 0)
 					{
-						work = node.generate_work (pub);
+						work = rpc.generate_work (pub).value_or (0);
+					}
+					if (work != 0)
+					{
+						rai::open_block open (source, representative, pub, prv, pub, work);
+						boost::property_tree::ptree response_l;
+						response_l.put ("hash", open.hash ().to_string ());
+						std::string contents;
+						open.serialize_json (contents);
+						response_l.put ("block", contents);
+						response (response_l);
+					}
+					else
+					{
+						error_response (response, "Work generation cancelled");
 					}
-					rai::open_block open (source, representative, pub, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", open.hash ().to_string ());
-					std::string contents;
-					open.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
 				}
 				else
 				{
@@ -1284,15 +1677,22 @@ void rai::rpc_handler::block_create ()
 				{
 					if (work == 0)
 					{
-						work = node.generate_work (previous);
+						work = rpc.generate_work (previous).value_or (0);
+					}
+					if (work != 0)
+					{
+						rai::receive_block receive (previous, source, prv, pub, work);
+						boost::property_tree::ptree response_l;
+						response_l.put ("hash", receive.hash ().to_string ());
+						std::string contents;
+						receive.serialize_json (contents);
+						response_l.put ("block", contents);
+						response (response_l);
+					}
+					else
+					{
+						error_response (response, "Work generation cancelled");
 					}
-					rai::receive_block receive (previous, source, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", receive.hash ().to_string ());
-					std::string contents;
-					receive.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
 				}
 				else
 				{
@@ -1305,15 +1705,22 @@ void rai::rpc_handler::block_create ()
 				{
 					if (work == 0)
 					{
-						work = node.generate_work (previous);
+						work = rpc.generate_work (previous).value_or (0);
+					}
+					if (work != 0)
+					{
+						rai::change_block change (previous, representative, prv, pub, work);
+						boost::property_tree::ptree response_l;
+						response_l.put ("hash", change.hash ().to_string ());
+						std::string contents;
+						change.serialize_json (contents);
+						response_l.put ("block", contents);
+						response (response_l);
+					}
+					else
+					{
+						error_response (response, "Work generation cancelled");
 					}
-					rai::change_block change (previous, representative, prv, pub, work);
-					boost::property_tree::ptree response_l;
-					response_l.put ("hash", change.hash ().to_string ());
-					std::string contents;
-					change.serialize_json (contents);
-					response_l.put ("block", contents);
-					response (response_l);
 				}
 				else
 				{
@@ -1328,15 +1735,22 @@ void rai::rpc_handler::block_create ()
 					{
 						if (work == 0)
 						{
-							work = node.generate_work (previous);
+							work = rpc.generate_work (previous).value_or (0);
+						}
+						if (work != 0)
+						{
+							rai::send_block send (previous, destination, balance.number () - amount.number (), prv, pub, work);
+							boost::property_tree::ptree response_l;
+							response_l.put ("hash", send.hash ().to_string ());
+							std::string contents;
+							send.serialize_json (contents);
+							response_l.put ("block", contents);
+							response (response_l);
+						}
+						else
+						{
+							error_response (response, "Work generation cancelled");
 						}
-						rai::send_block send (previous, destination, balance.number () - amount.number (), prv, pub, work);
-						boost::property_tree::ptree response_l;
-						response_l.put ("hash", send.hash ().to_string ());
-						std::string contents;
-						send.serialize_json (contents);
-						response_l.put ("block", contents);
-						response (response_l);
 					}
 					else
 					{
@@ -1441,6 +1855,29 @@ void rai::rpc_handler::bootstrap_any ()
 	response (response_l);
 }
 
+void rai::rpc_handler::bootstrap_peers ()
+{
+	boost::property_tree::ptree response_l;
+	boost::property_tree::ptree peers_l;
+	auto now (std::chrono::steady_clock::now ());
+	auto scores (node.bootstrap_initiator.peer_scores.list ());
+	for (auto i (scores.begin ()), n (scores.end ()); i != n; ++i)
+	{
+		std::stringstream text;
+		text << i->first;
+		boost::property_tree::ptree entry;
+		entry.put ("rate", std::to_string (i->second.rate));
+		entry.put ("blocks", std::to_string (i->second.blocks));
+		entry.put ("pulls", std::to_string (i->second.pulls));
+		entry.put ("failures", std::to_string (i->second.failures));
+		entry.put ("seconds", std::to_string (i->second.seconds));
+		entry.put ("last_pull", std::to_string (std::chrono::duration_cast<std::chrono::seconds> (now - i->second.last_pull).count ()));
+		peers_l.push_back (std::make_pair (text.str (), entry));
+	}
+	response_l.add_child ("peers", peers_l);
+	response (response_l);
+}
+
 void rai::rpc_handler::chain ()
 {
 	std::string block_text (request.get<std::string> ("block"));
@@ -1502,6 +1939,32 @@ void rai::rpc_handler::confirmation_history ()
 	response (response_l);
 }
 
+void rai::rpc_handler::confirmation_latency ()
+{
+	boost::property_tree::ptree response_l;
+	size_t count;
+	{
+		std::lock_guard<std::mutex> lock (node.active.latencies_mutex);
+		count = node.active.latencies.size ();
+	}
+	size_t active;
+	{
+		std::lock_guard<std::mutex> lock (node.active.mutex);
+		active = node.active.roots.size ();
+	}
+	response_l.put ("count", std::to_string (count));
+	response_l.put ("active", std::to_string (active));
+	auto percentiles (node.active.latency_percentiles ({ 0.5, 0.9, 0.99, 1.0 }));
+	if (!percentiles.empty ())
+	{
+		response_l.put ("p50", std::to_string (percentiles[0].count ()));
+		response_l.put ("p90", std::to_string (percentiles[1].count ()));
+		response_l.put ("p99", std::to_string (percentiles[2].count ()));
+		response_l.put ("max", std::to_string (percentiles[3].count ()));
+	}
+	response (response_l);
+}
+
 void rai::rpc_handler::delegators ()
 {
 	std::string account_text (request.get<std::string> ("account"));
@@ -1509,23 +1972,44 @@ void rai::rpc_handler::delegators ()
 	auto error (account.decode_account (account_text));
 	if (!error)
 	{
-		boost::property_tree::ptree response_l;
-		boost::property_tree::ptree delegators;
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		uint64_t count (std::numeric_limits<uint64_t>::max ());
+		boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
+		if (count_text.is_initialized ())
 		{
-			rai::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
+			error = decode_unsigned (count_text.get (), count);
+			if (error)
 			{
+				error_response (response, "Invalid count limit");
+			}
+		}
+		rai::account start (0);
+		boost::optional<std::string> start_text (request.get_optional<std::string> ("start"));
+		if (!error && start_text.is_initialized ())
+		{
+			error = start.decode_account (start_text.get ());
+			if (error)
+			{
+				error_response (response, "Invalid starting account");
+			}
+		}
+		if (!error)
+		{
+			boost::property_tree::ptree response_l;
+			boost::property_tree::ptree delegators;
+			rai::transaction transaction (node.store.environment, nullptr, false);
+			for (auto i (node.store.delegators_begin (transaction, account, start)), n (node.store.delegators_end ()); i != n && rai::block_store::delegator_representative (i->first) == account && delegators.size () < count; ++i)
+			{
+				rai::amount amount;
+				rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+				auto error (rai::read (stream, amount));
+				assert (!error);
 				std::string balance;
-				rai::uint128_union (info.balance).encode_dec (balance);
-				delegators.put (rai::account (i->first.uint256 ()).to_account (), balance);
+				amount.encode_dec (balance);
+				delegators.put (rai::block_store::delegator_account (i->first).to_account (), balance);
 			}
+			response_l.add_child ("delegators", delegators);
+			response (response_l);
 		}
-		response_l.add_child ("delegators", delegators);
-		response (response_l);
 	}
 	else
 	{
@@ -1542,15 +2026,9 @@ void rai::rpc_handler::delegators_count ()
 	{
 		uint64_t count (0);
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		for (auto i (node.store.delegators_begin (transaction, account)), n (node.store.delegators_end ()); i != n && rai::block_store::delegator_representative (i->first) == account; ++i)
 		{
-			rai::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
-			{
-				++count;
-			}
+			++count;
 		}
 		boost::property_tree::ptree response_l;
 		response_l.put ("count", std::to_string (count));
@@ -1609,15 +2087,19 @@ void rai::rpc_handler::frontiers ()
 		uint64_t count;
 		if (!decode_unsigned (count_text, count))
 		{
-			boost::property_tree::ptree response_l;
-			boost::property_tree::ptree frontiers;
+			std::string body_l;
+			rai::json_writer writer (body_l);
+			writer.begin_object ();
+			writer.begin_object ("frontiers");
 			rai::transaction transaction (node.store.environment, nullptr, false);
-			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && frontiers.size () < count; ++i)
+			uint64_t written (0);
+			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && written < count; ++i, ++written)
 			{
-				frontiers.put (rai::account (i->first.uint256 ()).to_account (), rai::account_info (i->second).head.to_string ());
+				writer.put (rai::account (i->first.uint256 ()).to_account (), rai::account_info (i->second).head.to_string ());
 			}
-			response_l.add_child ("frontiers", frontiers);
-			response (response_l);
+			writer.end ();
+			writer.end ();
+			response_body (std::move (body_l));
 		}
 		else
 		{
@@ -1921,123 +2403,109 @@ void rai::rpc_handler::ledger ()
 	{
 		rai::account start (0);
 		uint64_t count (std::numeric_limits<uint64_t>::max ());
+		auto error (false);
 		boost::optional<std::string> account_text (request.get_optional<std::string> ("account"));
 		if (account_text.is_initialized ())
 		{
-			auto error (start.decode_account (account_text.get ()));
+			error = start.decode_account (account_text.get ());
 			if (error)
 			{
 				error_response (response, "Invalid starting account");
 			}
 		}
 		boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
-		if (count_text.is_initialized ())
+		if (!error && count_text.is_initialized ())
 		{
-			auto error_count (decode_unsigned (count_text.get (), count));
-			if (error_count)
+			error = decode_unsigned (count_text.get (), count);
+			if (error)
 			{
 				error_response (response, "Invalid count limit");
 			}
 		}
-		uint64_t modified_since (0);
-		boost::optional<std::string> modified_since_text (request.get_optional<std::string> ("modified_since"));
-		if (modified_since_text.is_initialized ())
-		{
-			modified_since = strtoul (modified_since_text.get ().c_str (), NULL, 10);
-		}
-		const bool sorting = request.get<bool> ("sorting", false);
-		const bool representative = request.get<bool> ("representative", false);
-		const bool weight = request.get<bool> ("weight", false);
-		const bool pending = request.get<bool> ("pending", false);
-		boost::property_tree::ptree response_a;
-		boost::property_tree::ptree response_l;
-		boost::property_tree::ptree accounts;
-		rai::transaction transaction (node.store.environment, nullptr, false);
-		if (!sorting) // Simple
-		{
-			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && accounts.size () < count; ++i)
-			{
-				rai::account_info info (i->second);
-				if (info.modified >= modified_since)
-				{
-					rai::account account (i->first.uint256 ());
-					boost::property_tree::ptree response_l;
-					response_l.put ("frontier", info.head.to_string ());
-					response_l.put ("open_block", info.open_block.to_string ());
-					response_l.put ("representative_block", info.rep_block.to_string ());
-					std::string balance;
-					rai::uint128_union (info.balance).encode_dec (balance);
-					response_l.put ("balance", balance);
-					response_l.put ("modified_timestamp", std::to_string (info.modified));
-					response_l.put ("block_count", std::to_string (info.block_count));
-					if (representative)
-					{
-						auto block (node.store.block_get (transaction, info.rep_block));
-						assert (block != nullptr);
-						response_l.put ("representative", block->representative ().to_account ());
-					}
-					if (weight)
-					{
-						auto account_weight (node.ledger.weight (transaction, account));
-						response_l.put ("weight", account_weight.convert_to<std::string> ());
-					}
-					if (pending)
-					{
-						auto account_pending (node.ledger.account_pending (transaction, account));
-						response_l.put ("pending", account_pending.convert_to<std::string> ());
-					}
-					accounts.push_back (std::make_pair (account.to_account (), response_l));
-				}
-			}
-		}
-		else // Sorting
+		if (!error)
 		{
-			std::vector<std::pair<rai::uint128_union, rai::account>> ledger_l;
-			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n; ++i)
+			uint64_t modified_since (0);
+			boost::optional<std::string> modified_since_text (request.get_optional<std::string> ("modified_since"));
+			if (modified_since_text.is_initialized ())
 			{
-				rai::account_info info (i->second);
-				rai::uint128_union balance (info.balance);
-				if (info.modified >= modified_since)
-				{
-					ledger_l.push_back (std::make_pair (balance, rai::account (i->first.uint256 ())));
-				}
+				modified_since = strtoul (modified_since_text.get ().c_str (), NULL, 10);
 			}
-			std::sort (ledger_l.begin (), ledger_l.end ());
-			std::reverse (ledger_l.begin (), ledger_l.end ());
-			rai::account_info info;
-			for (auto i (ledger_l.begin ()), n (ledger_l.end ()); i != n && accounts.size () < count; ++i)
-			{
-				node.store.account_get (transaction, i->second, info);
-				rai::account account (i->second);
-				response_l.put ("frontier", info.head.to_string ());
-				response_l.put ("open_block", info.open_block.to_string ());
-				response_l.put ("representative_block", info.rep_block.to_string ());
+			const bool sorting = request.get<bool> ("sorting", false);
+			const bool representative = request.get<bool> ("representative", false);
+			const bool weight = request.get<bool> ("weight", false);
+			const bool pending = request.get<bool> ("pending", false);
+			std::string body_l;
+			rai::json_writer writer (body_l);
+			writer.begin_object ();
+			writer.begin_object ("accounts");
+			rai::transaction transaction (node.store.environment, nullptr, false);
+			auto account_write ([&](rai::account const & account_a, rai::account_info const & info_a) {
+				writer.begin_object (account_a.to_account ());
+				writer.put ("frontier", info_a.head.to_string ());
+				writer.put ("open_block", info_a.open_block.to_string ());
+				writer.put ("representative_block", info_a.rep_block.to_string ());
 				std::string balance;
-				(i->first).encode_dec (balance);
-				response_l.put ("balance", balance);
-				response_l.put ("modified_timestamp", std::to_string (info.modified));
-				response_l.put ("block_count", std::to_string (info.block_count));
+				rai::uint128_union (info_a.balance).encode_dec (balance);
+				writer.put ("balance", balance);
+				writer.put ("modified_timestamp", std::to_string (info_a.modified));
+				writer.put ("block_count", std::to_string (info_a.block_count));
 				if (representative)
 				{
-					auto block (node.store.block_get (transaction, info.rep_block));
+					auto block (node.store.block_get (transaction, info_a.rep_block));
 					assert (block != nullptr);
-					response_l.put ("representative", block->representative ().to_account ());
+					writer.put ("representative", block->representative ().to_account ());
 				}
 				if (weight)
 				{
-					auto account_weight (node.ledger.weight (transaction, account));
-					response_l.put ("weight", account_weight.convert_to<std::string> ());
+					auto account_weight (node.ledger.weight (transaction, account_a));
+					writer.put ("weight", account_weight.convert_to<std::string> ());
 				}
 				if (pending)
 				{
-					auto account_pending (node.ledger.account_pending (transaction, account));
-					response_l.put ("pending", account_pending.convert_to<std::string> ());
+					auto account_pending (node.ledger.account_pending (transaction, account_a));
+					writer.put ("pending", account_pending.convert_to<std::string> ());
+				}
+				writer.end ();
+			});
+			uint64_t written (0);
+			if (!sorting) // Simple
+			{
+				for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && written < count; ++i)
+				{
+					rai::account_info info (i->second);
+					if (info.modified >= modified_since)
+					{
+						account_write (rai::account (i->first.uint256 ()), info);
+						++written;
+					}
+				}
+			}
+			else // Sorting
+			{
+				std::vector<std::pair<rai::uint128_union, rai::account>> ledger_l;
+				for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n; ++i)
+				{
+					rai::account_info info (i->second);
+					rai::uint128_union balance (info.balance);
+					if (info.modified >= modified_since)
+					{
+						ledger_l.push_back (std::make_pair (balance, rai::account (i->first.uint256 ())));
+					}
+				}
+				std::sort (ledger_l.begin (), ledger_l.end ());
+				std::reverse (ledger_l.begin (), ledger_l.end ());
+				rai::account_info info;
+				for (auto i (ledger_l.begin ()), n (ledger_l.end ()); i != n && written < count; ++i)
+				{
+					node.store.account_get (transaction, i->second, info);
+					account_write (i->second, info);
+					++written;
 				}
-				accounts.push_back (std::make_pair (account.to_account (), response_l));
 			}
+			writer.end ();
+			writer.end ();
+			response_body (std::move (body_l));
 		}
-		response_a.add_child ("accounts", accounts);
-		response (response_a);
 	}
 	else
 	{
@@ -2844,24 +3312,20 @@ void rai::rpc_handler::representatives ()
 	const bool sorting = request.get<bool> ("sorting", false);
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree representatives;
-	rai::transaction transaction (node.store.environment, nullptr, false);
+	auto weights (node.store.representation_cache.list ());
 	if (!sorting) // Simple
 	{
-		for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n && representatives.size () < count; ++i)
+		for (auto i (weights.begin ()), n (weights.end ()); i != n && representatives.size () < count; ++i)
 		{
-			rai::account account (i->first.uint256 ());
-			auto amount (node.store.representation_get (transaction, account));
-			representatives.put (account.to_account (), amount.convert_to<std::string> ());
+			representatives.put (i->first.to_account (), i->second.convert_to<std::string> ());
 		}
 	}
 	else // Sorting
 	{
 		std::vector<std::pair<rai::uint128_union, std::string>> representation;
-		for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n; ++i)
+		for (auto i (weights.begin ()), n (weights.end ()); i != n; ++i)
 		{
-			rai::account account (i->first.uint256 ());
-			auto amount (node.store.representation_get (transaction, account));
-			representation.push_back (std::make_pair (amount, account.to_account ()));
+			representation.push_back (std::make_pair (i->second, i->first.to_account ()));
 		}
 		std::sort (representation.begin (), representation.end ());
 		std::reverse (representation.begin (), representation.end ());
@@ -3011,6 +3475,28 @@ void rai::rpc_handler::republish ()
 	}
 }
 
+void rai::rpc_handler::rpc_stats ()
+{
+	boost::property_tree::ptree response_l;
+	response_l.put ("connections", std::to_string (rpc.connections));
+	response_l.put ("connections_open", std::to_string (rpc.connections_open ()));
+	response_l.put ("requests", std::to_string (rpc.requests));
+	boost::property_tree::ptree executor_l;
+	for (auto class_l : { rai::rpc_request_class::point, rai::rpc_request_class::scan })
+	{
+		auto stats (rpc.executor.stats (class_l));
+		boost::property_tree::ptree entry;
+		entry.put ("requests", std::to_string (stats.requests));
+		entry.put ("queued", std::to_string (stats.queued));
+		entry.put ("active", std::to_string (stats.active));
+		entry.put ("queue_time_average", std::to_string (stats.requests > 0 ? stats.queue_time.count () / stats.requests : 0));
+		entry.put ("queue_time_max", std::to_string (stats.queue_time_max.count ()));
+		executor_l.add_child (class_l == rai::rpc_request_class::point ? "point" : "scan", entry);
+	}
+	response_l.add_child ("executor", executor_l);
+	response (response_l);
+}
+
 void rai::rpc_handler::search_pending ()
 {
 	if (rpc.config.enable_control)
@@ -3202,6 +3688,17 @@ void rai::rpc_handler::unchecked ()
 	}
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree unchecked;
+	node.store.unchecked_cached ([&unchecked, count](rai::block_hash const &, std::shared_ptr<rai::block> const & block_a) {
+		auto done (unchecked.size () >= count);
+		if (!done)
+		{
+			std::string contents;
+			block_a->serialize_json (contents);
+			unchecked.put (block_a->hash ().to_string (), contents);
+			done = unchecked.size () >= count;
+		}
+		return done;
+	});
 	rai::transaction transaction (node.store.environment, nullptr, false);
 	for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
 	{
@@ -3239,8 +3736,18 @@ void rai::rpc_handler::unchecked_get ()
 	if (!error)
 	{
 		boost::property_tree::ptree response_l;
+		node.store.unchecked_cached ([&response_l, &hash](rai::block_hash const &, std::shared_ptr<rai::block> const & block_a) {
+			auto found (block_a->hash () == hash);
+			if (found)
+			{
+				std::string contents;
+				block_a->serialize_json (contents);
+				response_l.put ("contents", contents);
+			}
+			return found;
+		});
 		rai::transaction transaction (node.store.environment, nullptr, false);
-		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n; ++i)
+		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && response_l.empty (); ++i)
 		{
 			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
 			auto block (rai::deserialize_block (stream));
@@ -3291,18 +3798,50 @@ void rai::rpc_handler::unchecked_keys ()
 	}
 	boost::property_tree::ptree response_l;
 	boost::property_tree::ptree unchecked;
-	rai::transaction transaction (node.store.environment, nullptr, false);
-	for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+	// Blocks held in memory are merged in key order with those in the unchecked table, only the first count of them from key onwards can be returned
+	std::vector<std::pair<rai::block_hash, std::shared_ptr<rai::block>>> cached;
+	node.store.unchecked_cached ([&cached, &key](rai::block_hash const & key_a, std::shared_ptr<rai::block> const & block_a) {
+		if (!(key_a.number () < key.number ()))
+		{
+			cached.push_back (std::make_pair (key_a, block_a));
+		}
+		return false;
+	});
+	auto key_order ([](std::pair<rai::block_hash, std::shared_ptr<rai::block>> const & lhs, std::pair<rai::block_hash, std::shared_ptr<rai::block>> const & rhs) { return lhs.first.number () < rhs.first.number (); });
+	if (cached.size () > count)
 	{
+		std::nth_element (cached.begin (), cached.begin () + count, cached.end (), key_order);
+		cached.erase (cached.begin () + count, cached.end ());
+	}
+	std::sort (cached.begin (), cached.end (), key_order);
+	auto add_entry ([&unchecked](rai::block_hash const & key_a, rai::block const & block_a) {
 		boost::property_tree::ptree entry;
-		rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
-		auto block (rai::deserialize_block (stream));
 		std::string contents;
-		block->serialize_json (contents);
-		entry.put ("key", rai::block_hash (i->first.uint256 ()).to_string ());
-		entry.put ("hash", block->hash ().to_string ());
+		block_a.serialize_json (contents);
+		entry.put ("key", key_a.to_string ());
+		entry.put ("hash", block_a.hash ().to_string ());
 		entry.put ("contents", contents);
 		unchecked.push_back (std::make_pair ("", entry));
+	});
+	auto j (cached.begin ());
+	rai::transaction transaction (node.store.environment, nullptr, false);
+	for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+	{
+		rai::block_hash stored_key (i->first.uint256 ());
+		for (; j != cached.end () && j->first.number () < stored_key.number () && unchecked.size () < count; ++j)
+		{
+			add_entry (j->first, *j->second);
+		}
+		if (unchecked.size () < count)
+		{
+			rai::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+			auto block (rai::deserialize_block (stream));
+			add_entry (stored_key, *block);
+		}
+	}
+	for (; j != cached.end () && unchecked.size () < count; ++j)
+	{
+		add_entry (j->first, *j->second);
 	}
 	response_l.add_child ("unchecked", unchecked);
 	response (response_l);
@@ -3887,65 +4426,37 @@ void rai::rpc_handler::wallet_pending ()
 			boost::optional<std::string> count_text (request.get_optional<std::string> ("count"));
 			if (count_text.is_initialized ())
 			{
-				auto error (decode_unsigned (count_text.get (), count));
+				error = decode_unsigned (count_text.get (), count);
 				if (error)
 				{
 					error_response (response, "Invalid count limit");
 				}
 			}
 			boost::optional<std::string> threshold_text (request.get_optional<std::string> ("threshold"));
-			if (threshold_text.is_initialized ())
+			if (!error && threshold_text.is_initialized ())
 			{
-				auto error_threshold (threshold.decode_dec (threshold_text.get ()));
-				if (error_threshold)
+				error = threshold.decode_dec (threshold_text.get ());
+				if (error)
 				{
 					error_response (response, "Bad threshold number");
 				}
 			}
-			const bool source = request.get<bool> ("source", false);
-			boost::property_tree::ptree response_l;
-			boost::property_tree::ptree pending;
-			rai::transaction transaction (node.store.environment, nullptr, false);
-			for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
+			if (!error)
 			{
-				rai::account account (i->first.uint256 ());
-				boost::property_tree::ptree peers_l;
-				rai::account end (account.number () + 1);
-				for (auto ii (node.store.pending_begin (transaction, rai::pending_key (account, 0))), nn (node.store.pending_begin (transaction, rai::pending_key (end, 0))); ii != nn && peers_l.size () < count; ++ii)
-				{
-					rai::pending_key key (ii->first);
-					if (threshold.is_zero () && !source)
-					{
-						boost::property_tree::ptree entry;
-						entry.put ("", key.hash.to_string ());
-						peers_l.push_back (std::make_pair ("", entry));
-					}
-					else
-					{
-						rai::pending_info info (ii->second);
-						if (info.amount.number () >= threshold.number ())
-						{
-							if (source)
-							{
-								boost::property_tree::ptree pending_tree;
-								pending_tree.put ("amount", info.amount.number ().convert_to<std::string> ());
-								pending_tree.put ("source", info.source.to_account ());
-								peers_l.add_child (key.hash.to_string (), pending_tree);
-							}
-							else
-							{
-								peers_l.put (key.hash.to_string (), info.amount.number ().convert_to<std::string> ());
-							}
-						}
-					}
-				}
-				if (!peers_l.empty ())
+				const bool source = request.get<bool> ("source", false);
+				std::string body_l;
+				rai::json_writer writer (body_l);
+				writer.begin_object ();
+				writer.begin_object ("blocks");
+				rai::transaction transaction (node.store.environment, nullptr, false);
+				for (auto i (existing->second->store.begin (transaction)), n (existing->second->store.end ()); i != n; ++i)
 				{
-					pending.add_child (account.to_account (), peers_l);
+					pending_write (writer, node, transaction, rai::account (i->first.uint256 ()), count, threshold, source, false);
 				}
+				writer.end ();
+				writer.end ();
+				response_body (std::move (body_l));
 			}
-			response_l.add_child ("blocks", pending);
-			response (response_l);
 		}
 		else
 		{
@@ -4157,7 +4668,8 @@ void rai::rpc_handler::work_generate ()
 				{
 					error_response (rpc_l->response, "Cancelled");
 				}
-			});
+			},
+			rai::work_priority::rpc);
 		}
 		else
 		{
@@ -4410,9 +4922,12 @@ void rai::rpc_handler::work_peers_clear ()
 rai::rpc_connection::rpc_connection (rai::node & node_a, rai::rpc & rpc_a) :
 node (node_a.shared ()),
 rpc (rpc_a),
-socket (node_a.service)
+socket (node_a.service),
+timeout (node_a.service),
+requests (0),
+idle (false),
+responded (0)
 {
-	responded.clear ();
 }
 
 void rai::rpc_connection::parse_connection ()
@@ -4420,63 +4935,119 @@ void rai::rpc_connection::parse_connection ()
 	read ();
 }
 
-void rai::rpc_connection::write_result (std::string body, unsigned version)
+// Keep the connection for another request unless the client asked to close it, it reached its request limit or the server is stopping
+bool rai::rpc_connection::keep_alive ()
+{
+	return request.keep_alive () && requests < rpc.config.keepalive_requests && !rpc.stopped;
+}
+
+// Reset for the next request, pipelined requests are already waiting in the read buffer
+void rai::rpc_connection::next ()
+{
+	request = boost::beast::http::request<boost::beast::http::string_body> ();
+	res = boost::beast::http::response<boost::beast::http::string_body> ();
+	read ();
+}
+
+void rai::rpc_connection::start_timeout ()
+{
+	idle = true;
+	timeout.expires_from_now (boost::posix_time::seconds (rpc.config.keepalive_timeout.count ()));
+	std::weak_ptr<rai::rpc_connection> this_w (shared_from_this ());
+	timeout.async_wait ([this_w](boost::system::error_code const & ec) {
+		if (ec != boost::asio::error::operation_aborted)
+		{
+			auto this_l (this_w.lock ());
+			if (this_l != nullptr)
+			{
+				this_l->socket.close ();
+			}
+		}
+	});
+}
+
+void rai::rpc_connection::stop_timeout ()
+{
+	idle = false;
+	size_t killed (timeout.cancel ());
+	(void)killed;
+}
+
+void rai::rpc_connection::close_idle ()
+{
+	if (idle)
+	{
+		socket.close ();
+	}
+}
+
+bool rai::rpc_connection::write_result (std::string body, unsigned version, unsigned request_a)
 {
-	if (!responded.test_and_set ())
+	// Only the first answer to the request after the last one answered is written
+	auto previous (request_a - 1);
+	auto result (!responded.compare_exchange_strong (previous, request_a));
+	if (!result)
 	{
 		res.set ("Content-Type", "application/json");
 		res.set ("Access-Control-Allow-Origin", "*");
 		res.set ("Access-Control-Allow-Headers", "Accept, Accept-Language, Content-Language, Content-Type");
-		res.set ("Connection", "close");
 		res.result (boost::beast::http::status::ok);
-		res.body () = body;
+		res.body () = std::move (body);
 		res.version (version);
+		res.keep_alive (keep_alive ());
 		res.prepare_payload ();
 	}
 	else
 	{
-		assert (false && "RPC already responded and should only respond once");
 		// Guards `res' from being clobbered while async_write is being serviced
+		BOOST_LOG (node->log) << "RPC already responded and should only respond once";
 	}
+	return result;
 }
 
 void rai::rpc_connection::read ()
 {
 	auto this_l (shared_from_this ());
+	start_timeout ();
 	boost::beast::http::async_read (socket, buffer, request, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		this_l->stop_timeout ();
 		if (!ec)
 		{
-			this_l->node->background ([this_l]() {
-				auto start (std::chrono::steady_clock::now ());
+			auto request_number (++this_l->requests);
+			++this_l->rpc.requests;
+			auto start (std::chrono::steady_clock::now ());
+			this_l->rpc.executor.add (rai::rpc_request_class::point, [this_l, start, request_number]() {
 				auto version (this_l->request.version ());
-				auto response_handler ([this_l, version, start](boost::property_tree::ptree const & tree_a) {
-
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, tree_a);
-					ostream.flush ();
-					auto body (ostream.str ());
-					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->socket, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
-					});
+				auto response_handler ([this_l, version, start, request_number](std::string body_a) {
+					if (!this_l->write_result (std::move (body_a), version, request_number))
+					{
+						boost::beast::http::async_write (this_l->socket, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+							if (!ec && this_l->res.keep_alive ())
+							{
+								this_l->next ();
+							}
+						});
+					}
 
 					if (this_l->node->config.logging.log_rpc ())
 					{
 						BOOST_LOG (this_l->node->log) << boost::str (boost::format ("RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ())));
 					}
 				});
+				auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler));
 				if (this_l->request.method () == boost::beast::http::verb::post)
 				{
-					auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler));
 					handler->process_request ();
 				}
 				else
 				{
-					error_response (response_handler, "Can only POST requests");
+					error_response (handler->response, "Can only POST requests");
 				}
 			});
 		}
-		else
+		else if (ec != boost::beast::http::error::end_of_stream && ec != boost::asio::error::operation_aborted)
 		{
+			// The client closing a persistent connection between requests isn't an error
 			BOOST_LOG (this_l->node->log) << "RPC read error: " << ec.message ();
 		}
 	});
@@ -4492,6 +5063,44 @@ void reprocess_body (std::string & body, boost::property_tree::ptree & tree_a)
 }
 }
 
+namespace
+{
+// Handlers which iterate a table or an account chain rather than looking up a few keys
+rai::rpc_request_class request_class (std::string const & action_a)
+{
+	static std::unordered_set<std::string> const scans = {
+		"account_history",
+		"account_list",
+		"accounts_pending",
+		"available_supply",
+		"block_count_type",
+		"chain",
+		"delegators",
+		"delegators_count",
+		"frontier_count",
+		"frontiers",
+		"history",
+		"ledger",
+		"pending",
+		"representatives",
+		"republish",
+		"search_pending_all",
+		"successors",
+		"unchecked",
+		"unchecked_get",
+		"unchecked_keys",
+		"wallet_balance_total",
+		"wallet_balances",
+		"wallet_export",
+		"wallet_frontiers",
+		"wallet_ledger",
+		"wallet_pending",
+		"wallet_republish"
+	};
+	return scans.find (action_a) != scans.end () ? rai::rpc_request_class::scan : rai::rpc_request_class::point;
+}
+}
+
 void rai::rpc_handler::process_request ()
 {
 	try
@@ -4521,6 +5130,33 @@ void rai::rpc_handler::process_request ()
 		{
 			BOOST_LOG (node.log) << body;
 		}
+		if (request_class (action) == rai::rpc_request_class::scan)
+		{
+			// Parsed as a point request, the scan itself waits for a scan slot
+			auto this_l (shared_from_this ());
+			rpc.executor.add (rai::rpc_request_class::scan, [this_l, action]() {
+				this_l->dispatch (action);
+			});
+		}
+		else
+		{
+			dispatch (action);
+		}
+	}
+	catch (std::runtime_error const & err)
+	{
+		error_response (response, "Unable to parse JSON");
+	}
+	catch (...)
+	{
+		error_response (response, "Internal server error in RPC");
+	}
+}
+
+void rai::rpc_handler::dispatch (std::string const & action)
+{
+	try
+	{
 		if (action == "account_balance")
 		{
 			account_balance ();
@@ -4633,6 +5269,10 @@ void rai::rpc_handler::process_request ()
 		{
 			bootstrap_any ();
 		}
+		else if (action == "bootstrap_peers")
+		{
+			bootstrap_peers ();
+		}
 		else if (action == "chain")
 		{
 			chain ();
@@ -4653,6 +5293,10 @@ void rai::rpc_handler::process_request ()
 		{
 			confirmation_history ();
 		}
+		else if (action == "confirmation_latency")
+		{
+			confirmation_latency ();
+		}
 		else if (action == "frontiers")
 		{
 			frontiers ();
@@ -4774,6 +5418,10 @@ void rai::rpc_handler::process_request ()
 		{
 			republish ();
 		}
+		else if (action == "rpc_stats")
+		{
+			rpc_stats ();
+		}
 		else if (action == "search_pending")
 		{
 			search_pending ();
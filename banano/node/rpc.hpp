@@ -7,6 +7,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <banano/node/utility.hpp>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace rai
 {
@@ -47,6 +48,12 @@ public:
 	bool enable_control;
 	uint64_t frontier_request_limit;
 	uint64_t chain_request_limit;
+	// Most requests served on one persistent connection and how long it may sit idle between requests
+	unsigned keepalive_requests;
+	std::chrono::seconds keepalive_timeout;
+	// Threads running request handlers and how many of them may run scans at once
+	unsigned executor_threads;
+	unsigned scan_concurrency;
 	rpc_secure_config secure;
 };
 enum class payment_status
@@ -61,20 +68,78 @@ enum class payment_status
 };
 class wallet;
 class payment_observer;
+class rpc_connection;
+// Point requests look up a few keys, scans iterate tables and are limited in how many run at once
+enum class rpc_request_class
+{
+	point,
+	scan
+};
+class rpc_queue_stats
+{
+public:
+	rpc_queue_stats ();
+	uint64_t requests;
+	size_t queued;
+	unsigned active;
+	// Total and longest time requests waited for a thread
+	std::chrono::microseconds queue_time;
+	std::chrono::microseconds queue_time_max;
+};
+class rpc_queue
+{
+public:
+	std::deque<std::pair<std::chrono::steady_clock::time_point, std::function<void()>>> items;
+	unsigned limit;
+	rai::rpc_queue_stats stats;
+};
+/** Runs RPC handlers on threads of their own so ledger scans don't hold up the node's io_service */
+class rpc_executor
+{
+public:
+	rpc_executor (unsigned, unsigned);
+	~rpc_executor ();
+	void add (rai::rpc_request_class, std::function<void()> const &);
+	void run ();
+	void stop ();
+	rai::rpc_queue_stats stats (rai::rpc_request_class);
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopped;
+	std::array<rai::rpc_queue, 2> queues;
+	std::vector<std::thread> threads;
+};
 class rpc
 {
 public:
 	rpc (boost::asio::io_service &, rai::node &, rai::rpc_config const &);
+	virtual ~rpc ();
 	void start ();
 	virtual void accept ();
 	void stop ();
+	// Blocks until work is generated for a handler, none if it was cancelled or the RPC is stopping
+	boost::optional<uint64_t> generate_work (rai::uint256_union const &);
+	void cancel_work ();
 	void observer_action (rai::account const &);
+	void connection_add (std::shared_ptr<rai::rpc_connection>);
+	size_t connections_open ();
 	boost::asio::ip::tcp::acceptor acceptor;
 	std::mutex mutex;
 	std::unordered_map<rai::account, std::shared_ptr<rai::payment_observer>> payment_observers;
 	rai::rpc_config config;
 	rai::node & node;
 	bool on;
+	std::atomic<bool> stopped;
+	// Totals since start, requests / connections is the reuse rate of persistent connections
+	std::atomic<uint64_t> connections;
+	std::atomic<uint64_t> requests;
+	std::mutex connections_mutex;
+	std::vector<std::weak_ptr<rai::rpc_connection>> open;
+	// Roots handlers are waiting on, cancelled when stopping so no executor thread is left blocked
+	std::mutex work_mutex;
+	std::unordered_multiset<rai::uint256_union> work_pending;
+	// Last so its threads are joined before anything a running handler uses is destroyed
+	rai::rpc_executor executor;
 	static uint16_t const rpc_port = rai::banano_network == rai::banano_networks::banano_live_network ? 7072 : 55000;
 };
 class rpc_connection : public std::enable_shared_from_this<rai::rpc_connection>
@@ -83,14 +148,25 @@ public:
 	rpc_connection (rai::node &, rai::rpc &);
 	virtual void parse_connection ();
 	virtual void read ();
-	virtual void write_result (std::string body, unsigned version);
+	// Returns true if the numbered request was already answered, in which case nothing should be written
+	virtual bool write_result (std::string body, unsigned version, unsigned request_a);
+	bool keep_alive ();
+	void next ();
+	void start_timeout ();
+	void stop_timeout ();
+	void close_idle ();
 	std::shared_ptr<rai::node> node;
 	rai::rpc & rpc;
 	boost::asio::ip::tcp::socket socket;
+	boost::asio::deadline_timer timeout;
+	// Requests read on this connection and whether it's waiting for the next one
+	unsigned requests;
+	std::atomic<bool> idle;
 	boost::beast::flat_buffer buffer;
 	boost::beast::http::request<boost::beast::http::string_body> request;
 	boost::beast::http::response<boost::beast::http::string_body> res;
-	std::atomic_flag responded;
+	// Number of the last request answered, later answers to the same request are dropped
+	std::atomic<unsigned> responded;
 };
 class payment_observer : public std::enable_shared_from_this<rai::payment_observer>
 {
@@ -109,11 +185,39 @@ public:
 	std::function<void(boost::property_tree::ptree const &)> response;
 	std::atomic_flag completed;
 };
+/**
+ * Appends JSON to a string as it's written, producing the same output as boost::property_tree::write_json
+ * for the equivalent tree. Values are strings, as they are in a ptree, and empty objects or arrays are written as "".
+ */
+class json_writer
+{
+public:
+	json_writer (std::string &);
+	// Keys are ignored for the root, which must be an object, and for elements of an array
+	void begin_object (std::string const & = std::string ());
+	void begin_array (std::string const & = std::string ());
+	void end ();
+	void put (std::string const &, std::string const &);
+	void push_back (std::string const &);
+	std::string & buffer;
+
+private:
+	void child (std::string const &);
+	void escape (std::string const &);
+	class level
+	{
+	public:
+		bool array;
+		bool empty;
+	};
+	std::vector<level> levels;
+};
 class rpc_handler : public std::enable_shared_from_this<rai::rpc_handler>
 {
 public:
-	rpc_handler (rai::node &, rai::rpc &, std::string const &, std::function<void(boost::property_tree::ptree const &)> const &);
+	rpc_handler (rai::node &, rai::rpc &, std::string const &, std::function<void(std::string)> const &);
 	void process_request ();
+	void dispatch (std::string const &);
 	void account_balance ();
 	void account_block_count ();
 	void account_create ();
@@ -141,8 +245,10 @@ public:
 	void block_create ();
 	void bootstrap ();
 	void bootstrap_any ();
+	void bootstrap_peers ();
 	void chain ();
 	void confirmation_history ();
+	void confirmation_latency ();
 	void delegators ();
 	void delegators_count ();
 	void deterministic_key ();
@@ -176,6 +282,7 @@ public:
 	void representatives ();
 	void representatives_online ();
 	void republish ();
+	void rpc_stats ();
 	void search_pending ();
 	void search_pending_all ();
 	void send ();
@@ -218,6 +325,8 @@ public:
 	rai::rpc & rpc;
 	boost::property_tree::ptree request;
 	std::function<void(boost::property_tree::ptree const &)> response;
+	// Receives the serialized body, handlers with large responses write it directly with a json_writer
+	std::function<void(std::string)> response_body;
 };
 /** Returns the correct RPC implementation based on TLS configuration */
 std::unique_ptr<rai::rpc> get_rpc (boost::asio::io_service & service_a, rai::node & node_a, rai::rpc_config const & config_a);
@@ -100,6 +100,7 @@ void rai::rpc_secure::accept ()
 		if (!ec)
 		{
 			accept ();
+			connection_add (connection);
 			connection->parse_connection ();
 		}
 		else
@@ -127,7 +128,7 @@ void rai::rpc_connection_secure::parse_connection ()
 
 void rai::rpc_connection_secure::on_shutdown (const boost::system::error_code & error)
 {
-	// No-op. We initiate the shutdown (since the RPC server kills the connection after each request)
+	// No-op. We initiate the shutdown once a connection won't be kept alive
 	// and we'll thus get an expected EOF error. If the client disconnects, a short-read error will be expected.
 }
 
@@ -146,28 +147,35 @@ void rai::rpc_connection_secure::handle_handshake (const boost::system::error_co
 void rai::rpc_connection_secure::read ()
 {
 	auto this_l (std::static_pointer_cast<rai::rpc_connection_secure> (shared_from_this ()));
+	start_timeout ();
 	boost::beast::http::async_read (stream, buffer, request, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		this_l->stop_timeout ();
 		if (!ec)
 		{
-			this_l->node->background ([this_l]() {
-				auto start (std::chrono::steady_clock::now ());
+			auto request_number (++this_l->requests);
+			++this_l->rpc.requests;
+			auto start (std::chrono::steady_clock::now ());
+			this_l->rpc.executor.add (rai::rpc_request_class::point, [this_l, start, request_number]() {
 				auto version (this_l->request.version ());
-				auto response_handler ([this_l, version, start](boost::property_tree::ptree const & tree_a) {
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, tree_a);
-					ostream.flush ();
-					auto body (ostream.str ());
-					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->stream, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
-
-						// Perform the SSL shutdown
-						this_l->stream.async_shutdown (
-						std::bind (
-						&rai::rpc_connection_secure::on_shutdown,
-						this_l,
-						std::placeholders::_1));
-
-					});
+				auto response_handler ([this_l, version, start, request_number](std::string body_a) {
+					if (!this_l->write_result (std::move (body_a), version, request_number))
+					{
+						boost::beast::http::async_write (this_l->stream, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+							if (!ec && this_l->res.keep_alive ())
+							{
+								this_l->next ();
+							}
+							else
+							{
+								// Perform the SSL shutdown
+								this_l->stream.async_shutdown (
+								std::bind (
+								&rai::rpc_connection_secure::on_shutdown,
+								this_l,
+								std::placeholders::_1));
+							}
+						});
+					}
 
 					if (this_l->node->config.logging.log_rpc ())
 					{
@@ -175,18 +183,18 @@ void rai::rpc_connection_secure::read ()
 					}
 				});
 
+				auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler));
 				if (this_l->request.method () == boost::beast::http::verb::post)
 				{
-					auto handler (std::make_shared<rai::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), response_handler));
 					handler->process_request ();
 				}
 				else
 				{
-					error_response (response_handler, "Can only POST requests");
+					error_response (handler->response, "Can only POST requests");
 				}
 			});
 		}
-		else
+		else if (ec != boost::beast::http::error::end_of_stream && ec != boost::asio::error::operation_aborted)
 		{
 			BOOST_LOG (this_l->node->log) << "TLS: Read error: " << ec.message () << std::endl;
 		}
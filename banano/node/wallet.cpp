@@ -763,6 +763,7 @@ rai::public_key rai::wallet::deterministic_insert (MDB_txn * transaction_a, bool
 		{
 			work_ensure (transaction_a, key);
 		}
+		node.wallets.representative_check (transaction_a, key);
 	}
 	return key;
 }
@@ -784,6 +785,7 @@ rai::public_key rai::wallet::insert_adhoc (MDB_txn * transaction_a, rai::raw_key
 		{
 			work_ensure (transaction_a, key);
 		}
+		node.wallets.representative_check (transaction_a, key);
 	}
 	return key;
 }
@@ -821,12 +823,18 @@ bool rai::wallet::import (std::string const & json_a, std::string const & passwo
 		rai::transaction transaction (store.environment, nullptr, false);
 		error = temp->attempt_password (transaction, password_a);
 	}
-	rai::transaction transaction (store.environment, nullptr, true);
+	{
+		rai::transaction transaction (store.environment, nullptr, true);
+		if (!error)
+		{
+			error = store.import (transaction, *temp);
+		}
+		temp->destroy (transaction);
+	}
 	if (!error)
 	{
-		error = store.import (transaction, *temp);
+		node.wallets.compute_reps ();
 	}
-	temp->destroy (transaction);
 	return error;
 }
 
@@ -917,15 +925,6 @@ std::shared_ptr<rai::block> rai::wallet::receive_action (rai::block const & send
 		node.block_arrival.add (block->hash ());
 		node.block_processor.add (block);
 		node.block_processor.flush ();
-		if (generate_work_a)
-		{
-			auto hash (block->hash ());
-			auto this_l (shared_from_this ());
-			auto source (account);
-			node.wallets.queue_wallet_action (rai::wallets::generate_priority, [this_l, source, hash] {
-				this_l->work_generate (source, hash);
-			});
-		}
 	}
 	return block;
 }
@@ -968,14 +967,6 @@ std::shared_ptr<rai::block> rai::wallet::change_action (rai::account const & sou
 		node.block_arrival.add (block->hash ());
 		node.block_processor.add (block);
 		node.block_processor.flush ();
-		if (generate_work_a)
-		{
-			auto hash (block->hash ());
-			auto this_l (shared_from_this ());
-			node.wallets.queue_wallet_action (rai::wallets::generate_priority, [this_l, source_a, hash] {
-				this_l->work_generate (source_a, hash);
-			});
-		}
 	}
 	return block;
 }
@@ -1062,11 +1053,6 @@ std::shared_ptr<rai::block> rai::wallet::send_action (rai::account const & sourc
 		node.block_arrival.add (block->hash ());
 		node.block_processor.add (block);
 		node.block_processor.flush ();
-		auto hash (block->hash ());
-		auto this_l (shared_from_this ());
-		node.wallets.queue_wallet_action (rai::wallets::generate_priority, [this_l, source_a, hash] {
-			this_l->work_generate (source_a, hash);
-		});
 	}
 	return block;
 }
@@ -1179,10 +1165,7 @@ void rai::wallet::work_ensure (MDB_txn * transaction_a, rai::account const & acc
 	assert (!error);
 	if (rai::work_validate (root, work))
 	{
-		auto this_l (shared_from_this ());
-		node.background ([this_l, account_a, root]() {
-			this_l->work_generate (account_a, root);
-		});
+		node.wallets.work_precache (account_a, root);
 	}
 }
 
@@ -1357,7 +1340,7 @@ rai::public_key rai::wallet::change_seed (MDB_txn * transaction_a, rai::raw_key
 void rai::wallet::work_generate (rai::account const & account_a, rai::block_hash const & root_a)
 {
 	auto begin (std::chrono::steady_clock::now ());
-	auto work (node.generate_work (root_a));
+	auto work (node.generate_work (root_a, rai::work_priority::precache));
 	if (node.config.logging.work_generation_time ())
 	{
 		BOOST_LOG (node.log) << "Work generation complete: " << (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - begin).count ()) << " us";
@@ -1468,8 +1451,17 @@ void rai::wallets::destroy (rai::uint256_union const & id_a)
 	auto existing (items.find (id_a));
 	assert (existing != items.end ());
 	auto wallet (existing->second);
+	std::vector<rai::account> accounts;
+	for (auto i (wallet->store.begin (transaction)), n (wallet->store.end ()); i != n; ++i)
+	{
+		accounts.push_back (i->first.uint256 ());
+	}
 	items.erase (existing);
 	wallet->store.destroy (transaction);
+	for (auto & i : accounts)
+	{
+		representative_check (transaction, i);
+	}
 }
 
 void rai::wallets::do_wallet_actions ()
@@ -1504,20 +1496,26 @@ void rai::wallets::queue_wallet_action (rai::uint128_t const & amount_a, std::fu
 
 void rai::wallets::foreach_representative (MDB_txn * transaction_a, std::function<void(rai::public_key const & pub_a, rai::raw_key const & prv_a)> const & action_a)
 {
+	std::vector<rai::account> representatives_l;
+	{
+		std::lock_guard<std::mutex> lock (representatives_mutex);
+		representatives_l.assign (representatives.begin (), representatives.end ());
+	}
 	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
 	{
 		auto & wallet (*i->second);
-		for (auto j (wallet.store.begin (transaction_a)), m (wallet.store.end ()); j != m; ++j)
+		for (auto & account : representatives_l)
 		{
-			rai::account account (j->first.uint256 ());
-			if (!node.ledger.weight (transaction_a, account).is_zero ())
+			if (wallet.store.exists (transaction_a, account) && !node.ledger.weight (transaction_a, account).is_zero ())
 			{
 				if (wallet.store.valid_password (transaction_a))
 				{
 					rai::raw_key prv;
-					auto error (wallet.store.fetch (transaction_a, j->first.uint256 (), prv));
-					assert (!error);
-					action_a (j->first.uint256 (), prv);
+					auto error (wallet.store.fetch (transaction_a, account, prv));
+					if (!error)
+					{
+						action_a (account, prv);
+					}
 				}
 				else
 				{
@@ -1533,6 +1531,146 @@ void rai::wallets::foreach_representative (MDB_txn * transaction_a, std::functio
 	}
 }
 
+// Rebuild the representative set by checking the weight of every wallet account
+void rai::wallets::compute_reps ()
+{
+	std::unordered_set<rai::account> representatives_l;
+	{
+		rai::transaction transaction (node.store.environment, nullptr, false);
+		for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
+		{
+			auto & wallet (*i->second);
+			for (auto j (wallet.store.begin (transaction)), m (wallet.store.end ()); j != m; ++j)
+			{
+				rai::account account (j->first.uint256 ());
+				if (!node.ledger.weight (transaction, account).is_zero ())
+				{
+					representatives_l.insert (account);
+				}
+			}
+		}
+	}
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	representatives.swap (representatives_l);
+}
+
+// Keep account in the representative set only while it belongs to a wallet and has voting weight
+void rai::wallets::representative_check (MDB_txn * transaction_a, rai::account const & account_a)
+{
+	auto exists (false);
+	if (!account_a.is_zero () && !node.ledger.weight (transaction_a, account_a).is_zero ())
+	{
+		for (auto i (items.begin ()), n (items.end ()); !exists && i != n; ++i)
+		{
+			exists = i->second->store.exists (transaction_a, account_a);
+		}
+	}
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	if (exists)
+	{
+		representatives.insert (account_a);
+	}
+	else
+	{
+		representatives.erase (account_a);
+	}
+}
+
+// Queue generating work on root_a for account_a, a newer root replaces one that hasn't started yet and cancels one being generated
+void rai::wallets::work_precache (rai::account const & account_a, rai::block_hash const & root_a)
+{
+	boost::optional<rai::block_hash> stale;
+	{
+		std::lock_guard<std::mutex> lock (precache_mutex);
+		auto active (precache_active.find (account_a));
+		if (active == precache_active.end () || active->second != root_a)
+		{
+			if (active != precache_active.end ())
+			{
+				stale = active->second;
+			}
+			auto existing (precache_roots.find (account_a));
+			if (existing == precache_roots.end ())
+			{
+				precache_queue.push_back (account_a);
+				precache_roots[account_a] = root_a;
+			}
+			else
+			{
+				existing->second = root_a;
+			}
+		}
+	}
+	if (stale)
+	{
+		// The account's frontier has moved on so work for the old root would never be used
+		node.work.cancel (*stale);
+	}
+	precache_start ();
+}
+
+// Start generating for queued accounts until precache_batch roots are in progress
+void rai::wallets::precache_start ()
+{
+	std::vector<std::pair<rai::account, rai::block_hash>> start;
+	{
+		std::lock_guard<std::mutex> lock (precache_mutex);
+		while (precache_active.size () < precache_batch && !precache_queue.empty ())
+		{
+			auto account (precache_queue.front ());
+			precache_queue.pop_front ();
+			auto existing (precache_roots.find (account));
+			assert (existing != precache_roots.end ());
+			// Replaces a cancelled root of the account which hasn't called back yet
+			precache_active[account] = existing->second;
+			start.push_back (*existing);
+			precache_roots.erase (existing);
+		}
+	}
+	if (!start.empty ())
+	{
+		auto node_l (node.shared ());
+		for (auto & i : start)
+		{
+			auto account (i.first);
+			auto root (i.second);
+			node.generate_work (root, [node_l, account, root](boost::optional<uint64_t> const & work_a) {
+				// Called on a work thread, don't hold it while waiting for a write transaction
+				node_l->background ([node_l, account, root, work_a]() {
+					// None if the request was cancelled or expired, the root still has to leave the active set
+					if (work_a)
+					{
+						node_l->wallets.work_cache (account, root, *work_a);
+					}
+					{
+						std::lock_guard<std::mutex> lock (node_l->wallets.precache_mutex);
+						auto existing (node_l->wallets.precache_active.find (account));
+						if (existing != node_l->wallets.precache_active.end () && existing->second == root)
+						{
+							node_l->wallets.precache_active.erase (existing);
+						}
+					}
+					node_l->wallets.precache_start ();
+				});
+			},
+			rai::work_priority::precache);
+		}
+	}
+}
+
+// Store work for account_a in every wallet holding it, as long as root_a is still its latest root
+void rai::wallets::work_cache (rai::account const & account_a, rai::block_hash const & root_a, uint64_t work_a)
+{
+	rai::transaction transaction (node.store.environment, nullptr, true);
+	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
+	{
+		if (i->second->store.exists (transaction, account_a))
+		{
+			i->second->work_update (transaction, account_a, root_a, work_a);
+		}
+	}
+}
+
 bool rai::wallets::exists (MDB_txn * transaction_a, rai::public_key const & account_a)
 {
 	auto result (false);
@@ -1550,6 +1688,11 @@ void rai::wallets::stop ()
 		stopped = true;
 		condition.notify_all ();
 	}
+	{
+		std::lock_guard<std::mutex> lock (precache_mutex);
+		precache_queue.clear ();
+		precache_roots.clear ();
+	}
 	if (thread.joinable ())
 	{
 		thread.join ();
@@ -1558,6 +1701,7 @@ void rai::wallets::stop ()
 
 rai::uint128_t const rai::wallets::generate_priority = std::numeric_limits<rai::uint128_t>::max ();
 rai::uint128_t const rai::wallets::high_priority = std::numeric_limits<rai::uint128_t>::max () - 1;
+size_t constexpr rai::wallets::precache_batch;
 
 rai::store_iterator rai::wallet_store::begin (MDB_txn * transaction_a)
 {
@@ -5,6 +5,7 @@
 #include <banano/node/common.hpp>
 #include <banano/node/openclwork.hpp>
 
+#include <deque>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -174,9 +175,23 @@ public:
 	void queue_wallet_action (rai::uint128_t const &, std::function<void()> const &);
 	void foreach_representative (MDB_txn *, std::function<void(rai::public_key const &, rai::raw_key const &)> const &);
 	bool exists (MDB_txn *, rai::public_key const &);
+	void compute_reps ();
+	void representative_check (MDB_txn *, rai::account const &);
+	void work_precache (rai::account const &, rai::block_hash const &);
+	void precache_start ();
+	void work_cache (rai::account const &, rai::block_hash const &, uint64_t);
 	void stop ();
 	std::function<void(bool)> observer;
 	std::unordered_map<rai::uint256_union, std::shared_ptr<rai::wallet>> items;
+	// Wallet accounts which have had voting weight, vote generation only considers these
+	std::unordered_set<rai::account> representatives;
+	std::mutex representatives_mutex;
+	// Wallet accounts waiting for work on their latest root, oldest first
+	std::deque<rai::account> precache_queue;
+	std::unordered_map<rai::account, rai::block_hash> precache_roots;
+	// Root currently being generated for each account, at most precache_batch at once
+	std::unordered_map<rai::account, rai::block_hash> precache_active;
+	std::mutex precache_mutex;
 	std::multimap<rai::uint128_t, std::function<void()>, std::greater<rai::uint128_t>> actions;
 	std::mutex mutex;
 	std::condition_variable condition;
@@ -188,5 +203,6 @@ public:
 	std::thread thread;
 	static rai::uint128_t const generate_priority;
 	static rai::uint128_t const high_priority;
+	static size_t constexpr precache_batch = 16;
 };
 }